@@ -2,18 +2,15 @@
 
 #include "UE4TopDownCamera.h"
 #include "TDCAIController.h"
+#include "Navigation/PathFollowingComponent.h"
 
 ATDCAIController::ATDCAIController(const class FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	this->bAttachToPawn = true;
-}
-
-void ATDCAIController::Possess(class APawn* inPawn)
-{
-	Super::Possess(inPawn);
 
-	SetActorTickEnabled(true);
+	// the pawn turns to its movement on its own, path following ticks as a component
+	PrimaryActorTick.bCanEverTick = false;
 }
 
 void ATDCAIController::UnPossess()
@@ -34,4 +31,18 @@ void ATDCAIController::UnPossess()
 
 	SetActorTickEnabled(false);
 	Super::UnPossess();
-}
\ No newline at end of file
+}
+
+void ATDCAIController::SetPooled(bool bPooled)
+{
+	if (bPooled)
+	{
+		// drop the path being followed, the pawn is teleported when it leaves the pool
+		StopMovement();
+	}
+
+	if (GetPathFollowingComponent())
+	{
+		GetPathFollowingComponent()->SetComponentTickEnabled(!bPooled);
+	}
+}
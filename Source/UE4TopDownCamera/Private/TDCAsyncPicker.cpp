@@ -0,0 +1,209 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCAsyncPicker.h"
+#include "TDCCameraHelpers.h"
+#include "TDCStats.h"
+
+/** trace user data: flush generation in the high bits, pick index in the low bits */
+#define PICK_INDEX_BITS 16
+#define PICK_INDEX_MASK ((1 << PICK_INDEX_BITS) - 1)
+
+/** number of cached picks, hover, click and a few touches, from the last few cameras */
+#define MAX_CACHED_PICKS 16
+
+UTDCAsyncPicker::UTDCAsyncPicker(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, ScreenEpsilon(2.0f)
+	, CameraLocationEpsilon(1.0f)
+	, CameraRotationEpsilon(0.01f)
+	, MaxCacheAge(0.1f)
+	, InFlightGeneration(0)
+	, InFlightCameraLocation(FVector::ZeroVector)
+	, InFlightCameraRotation(FRotator::ZeroRotator)
+	, InFlightTime(0.0)
+{
+	TraceDelegate.BindUObject(this, &UTDCAsyncPicker::OnTraceCompleted);
+}
+
+void UTDCAsyncPicker::GetCameraTransform(FVector& OutLocation, FRotator& OutRotation) const
+{
+	APlayerController* MyController = CastChecked<APlayerController>(GetOuter());
+	if (MyController->PlayerCameraManager)
+	{
+		OutLocation = MyController->PlayerCameraManager->GetCameraLocation();
+		OutRotation = MyController->PlayerCameraManager->GetCameraRotation();
+	}
+	else
+	{
+		OutLocation = FVector::ZeroVector;
+		OutRotation = FRotator::ZeroRotator;
+	}
+}
+
+int32 UTDCAsyncPicker::FindCachedPick(const FVector2D& ScreenPosition, ECollisionChannel Channel, const FVector& CameraLocation, const FRotator& CameraRotation) const
+{
+	// newest first, they are the most likely to be asked for again
+	for (int32 CacheIndex = CachedPicks.Num() - 1; CacheIndex >= 0; CacheIndex--)
+	{
+		const FTDCCachedPick& CachedPick = CachedPicks[CacheIndex];
+		if (CachedPick.Channel == Channel && CachedPick.ScreenPosition.Equals(ScreenPosition, ScreenEpsilon) &&
+			CachedPick.CameraLocation.Equals(CameraLocation, CameraLocationEpsilon) && CachedPick.CameraRotation.Equals(CameraRotation, CameraRotationEpsilon))
+		{
+			return CacheIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+bool UTDCAsyncPicker::IsCachedPickValid(const FTDCCachedPick& CachedPick, double Now) const
+{
+	if (MaxCacheAge > 0.0f && Now - CachedPick.Time > MaxCacheAge)
+	{
+		return false;
+	}
+
+	// the actor hit was destroyed since
+	return !CachedPick.bBlockingHit || CachedPick.Hit.Actor.IsValid();
+}
+
+void UTDCAsyncPicker::RequestPick(const FVector2D& ScreenPosition, ECollisionChannel Channel, const FTDCPickDelegate& OnPicked, bool bAllowCached)
+{
+	if (bAllowCached && CachedPicks.Num() > 0)
+	{
+		FVector CameraLocation;
+		FRotator CameraRotation;
+		GetCameraTransform(CameraLocation, CameraRotation);
+
+		const int32 CacheIndex = FindCachedPick(ScreenPosition, Channel, CameraLocation, CameraRotation);
+		if (CacheIndex != INDEX_NONE && IsCachedPickValid(CachedPicks[CacheIndex], FPlatformTime::Seconds()))
+		{
+			TDC_INC_COUNTER(PickCacheHits);
+
+			// delivered on the next flush, like a trace requested now
+			const FTDCCachedPick& CachedPick = CachedPicks[CacheIndex];
+			FTDCReadyPick& ReadyPick = ReadyPicks[ReadyPicks.AddDefaulted()];
+			ReadyPick.Callback = OnPicked;
+			ReadyPick.bBlockingHit = CachedPick.bBlockingHit;
+			ReadyPick.Hit = CachedPick.Hit;
+			return;
+		}
+	}
+
+	for (FTDCPickRequest& Pick : PendingPicks)
+	{
+		if (Pick.ScreenPosition == ScreenPosition && Pick.Channel == Channel)
+		{
+			Pick.Callbacks.Add(OnPicked);
+			return;
+		}
+	}
+
+	if (PendingPicks.Num() > PICK_INDEX_MASK)
+	{
+		return;
+	}
+
+	// other channels under the same point share the ray
+	int32 RayIndex = ScreenPositions.Find(ScreenPosition);
+	if (RayIndex == INDEX_NONE)
+	{
+		RayIndex = ScreenPositions.Add(ScreenPosition);
+	}
+
+	FTDCPickRequest& Pick = PendingPicks[PendingPicks.AddDefaulted()];
+	Pick.ScreenPosition = ScreenPosition;
+	Pick.Channel = Channel;
+	Pick.RayIndex = RayIndex;
+	Pick.Callbacks.Add(OnPicked);
+}
+
+void UTDCAsyncPicker::Flush()
+{
+	// cached picks requested last frame, answered a frame later like the traces; the callbacks may pick again
+	Swap(DeliveringPicks, LastFrameReadyPicks);
+	for (const FTDCReadyPick& ReadyPick : DeliveringPicks)
+	{
+		ReadyPick.Callback.ExecuteIfBound(ReadyPick.bBlockingHit, ReadyPick.Hit);
+	}
+	DeliveringPicks.Reset();
+	Swap(LastFrameReadyPicks, ReadyPicks);
+
+	if (PendingPicks.Num() == 0)
+	{
+		return;
+	}
+
+	APlayerController* MyController = CastChecked<APlayerController>(GetOuter());
+	UWorld* World = MyController->GetWorld();
+
+	// one projection for all the picks of the frame
+	if (World == NULL || !FTDCCameraHelpers::DeprojectScreenToWorldBatch(ScreenPositions, Cast<ULocalPlayer>(MyController->Player), RayOrigins, RayDirections))
+	{
+		PendingPicks.Reset();
+		ScreenPositions.Reset();
+		return;
+	}
+
+	// results of the previous flush have been delivered at the start of this frame, anything left is dropped
+	Swap(PendingPicks, InFlightPicks);
+	PendingPicks.Reset();
+	InFlightGeneration++;
+	GetCameraTransform(InFlightCameraLocation, InFlightCameraRotation);
+	InFlightTime = FPlatformTime::Seconds();
+
+	const FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TDCAsyncPick), true);
+	for (int32 PickIndex = 0; PickIndex < InFlightPicks.Num(); PickIndex++)
+	{
+		const FTDCPickRequest& Pick = InFlightPicks[PickIndex];
+		const FVector TraceStart = RayOrigins[Pick.RayIndex];
+		const FVector TraceEnd = TraceStart + RayDirections[Pick.RayIndex] * MyController->HitResultTraceDistance;
+
+		TDC_INC_COUNTER(PhysicsTraces);
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, Pick.Channel, TraceParams,
+			FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, (InFlightGeneration << PICK_INDEX_BITS) | PickIndex);
+	}
+
+	ScreenPositions.Reset();
+}
+
+void UTDCAsyncPicker::OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	const uint32 Generation = TraceDatum.UserData >> PICK_INDEX_BITS;
+	const int32 PickIndex = TraceDatum.UserData & PICK_INDEX_MASK;
+	if (Generation != (InFlightGeneration & (MAX_uint32 >> PICK_INDEX_BITS)) || !InFlightPicks.IsValidIndex(PickIndex))
+	{
+		return;
+	}
+
+	static const FHitResult NoHit;
+	const FHitResult* Hit = TraceDatum.OutHits.Num() > 0 ? &TraceDatum.OutHits[0] : &NoHit;
+	const bool bBlockingHit = Hit->bBlockingHit;
+
+	// a refreshed pick replaces the one from the same camera, picks from other cameras are kept until they are the oldest
+	const FTDCPickRequest& Pick = InFlightPicks[PickIndex];
+	int32 CacheIndex = FindCachedPick(Pick.ScreenPosition, Pick.Channel, InFlightCameraLocation, InFlightCameraRotation);
+	if (CacheIndex == INDEX_NONE)
+	{
+		if (CachedPicks.Num() >= MAX_CACHED_PICKS)
+		{
+			CachedPicks.RemoveAt(0, 1, false);
+		}
+		CacheIndex = CachedPicks.AddDefaulted();
+	}
+
+	FTDCCachedPick& CachedPick = CachedPicks[CacheIndex];
+	CachedPick.ScreenPosition = Pick.ScreenPosition;
+	CachedPick.Channel = Pick.Channel;
+	CachedPick.CameraLocation = InFlightCameraLocation;
+	CachedPick.CameraRotation = InFlightCameraRotation;
+	CachedPick.Time = InFlightTime;
+	CachedPick.bBlockingHit = bBlockingHit;
+	CachedPick.Hit = *Hit;
+
+	for (const FTDCPickDelegate& Callback : InFlightPicks[PickIndex].Callbacks)
+	{
+		Callback.ExecuteIfBound(bBlockingHit, *Hit);
+	}
+}
@@ -0,0 +1,170 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCBakeHeightfieldCommandlet.h"
+#include "TDCHeightfield.h"
+#include "TDCCameraHelpers.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+
+/** default distance between two samples */
+static const float DefaultBakeCellSize = 100.0f;
+
+/** traces start and end this far outside of the level bounds */
+static const float BakeTraceMargin = 100.0f;
+
+UTDCBakeHeightfieldCommandlet::UTDCBakeHeightfieldCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTDCBakeHeightfieldCommandlet::Main(const FString& Params)
+{
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=TDCBakeHeightfield -Map=/Game/Maps/MyMap [-CellSize=100]"));
+		return 1;
+	}
+
+	float CellSize = DefaultBakeCellSize;
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	if (CellSize <= 0.0f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("CellSize must be positive"));
+		return 1;
+	}
+
+	UPackage* const Package = LoadPackage(NULL, *MapName, LOAD_None);
+	UWorld* const World = Package ? UWorld::FindWorldInPackage(Package) : NULL;
+	if (World == NULL)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cannot load map %s"), *MapName);
+		return 1;
+	}
+
+	// physics scene for the traces, nothing else
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+		World->InitWorld(IVS);
+	}
+	World->UpdateWorldComponents(true, false);
+
+	// every streaming level at once, their grounds are baked where they are placed in the map
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		if (StreamingLevel)
+		{
+			StreamingLevel->SetShouldBeLoaded(true);
+			StreamingLevel->SetShouldBeVisible(true);
+		}
+	}
+	World->FlushLevelStreaming();
+
+	int32 NumFailed = 0;
+	if (!BakeLevel(World, World->PersistentLevel, FVector::ZeroVector, CellSize))
+	{
+		NumFailed++;
+	}
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		ULevel* const Level = StreamingLevel ? StreamingLevel->GetLoadedLevel() : NULL;
+		if (Level == NULL)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Streaming level %s did not load, not baked"), StreamingLevel ? *StreamingLevel->GetWorldAssetPackageName() : TEXT("None"));
+			NumFailed++;
+			continue;
+		}
+
+		if (!BakeLevel(World, Level, StreamingLevel->LevelTransform.GetLocation(), CellSize))
+		{
+			NumFailed++;
+		}
+	}
+
+	World->RemoveFromRoot();
+	World->DestroyWorld(false);
+
+	return NumFailed > 0 ? 1 : 0;
+}
+
+bool UTDCBakeHeightfieldCommandlet::BakeLevel(UWorld* World, ULevel* Level, const FVector& LevelOffset, float CellSize)
+{
+	const FString LevelPackageName = Level->GetOutermost()->GetName();
+
+	const FBox Bounds = ALevelBounds::CalculateLevelBounds(Level);
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Level %s has no bounds, not baked"), *LevelPackageName);
+		return true;
+	}
+
+	// the ground of this level only, the others bake their own
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TDCBakeHeightfield), true);
+	for (ULevel* OtherLevel : World->GetLevels())
+	{
+		if (OtherLevel != Level)
+		{
+			TraceParams.AddIgnoredActors(OtherLevel->Actors);
+		}
+	}
+
+	// whole tiles, starting at the minimum corner of the bounds
+	const int32 NumTilesX = FMath::DivideAndRoundUp(FMath::CeilToInt(Bounds.GetSize().X / CellSize) + 1, TDC_HEIGHTFIELD_TILE_SIZE);
+	const int32 NumTilesY = FMath::DivideAndRoundUp(FMath::CeilToInt(Bounds.GetSize().Y / CellSize) + 1, TDC_HEIGHTFIELD_TILE_SIZE);
+	const int32 NumSamplesX = NumTilesX * TDC_HEIGHTFIELD_TILE_SIZE;
+	const int32 NumSamplesY = NumTilesY * TDC_HEIGHTFIELD_TILE_SIZE;
+	const FVector2D Origin(Bounds.Min);
+
+	TArray<float> Heights;
+	Heights.SetNumUninitialized(NumSamplesX * NumSamplesY);
+
+	int32 NumHits = 0;
+	for (int32 Y = 0; Y < NumSamplesY; Y++)
+	{
+		for (int32 X = 0; X < NumSamplesX; X++)
+		{
+			const FVector2D Location = Origin + FVector2D(X, Y) * CellSize;
+
+			FHitResult Hit;
+			if (World->LineTraceSingleByChannel(Hit, FVector(Location, Bounds.Max.Z + BakeTraceMargin), FVector(Location, Bounds.Min.Z - BakeTraceMargin), COLLISION_PANCAMERA, TraceParams))
+			{
+				Heights[Y * NumSamplesX + X] = Hit.ImpactPoint.Z;
+				NumHits++;
+			}
+			else
+			{
+				Heights[Y * NumSamplesX + X] = MAX_flt;
+			}
+		}
+	}
+
+	if (NumHits == 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Level %s has no ground on COLLISION_PANCAMERA, not baked"), *LevelPackageName);
+		return true;
+	}
+
+	const FString Filename = FTDCHeightfieldSampler::GetHeightfieldFilename(LevelPackageName);
+	if (!FTDCHeightfield::Write(Filename, Origin, CellSize, NumTilesX, NumTilesY, LevelOffset, Heights))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cannot write heightfield %s"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Baked %s: %dx%d samples, %d on the ground, into %s"), *LevelPackageName, NumSamplesX, NumSamplesY, NumHits, *Filename);
+	return true;
+}
@@ -0,0 +1,582 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCCameraHelpers.h"
+#include "TDCPlayerController.h"
+#include "TDCSelectionIndex.h"
+#include "TDCSpectatorPawn.h"
+#include "TDCInput.h"
+#include "Misc/AutomationTest.h"
+
+/** Console commands timing the camera hot paths in a running game, and the automation tests of the hot paths. */
+
+static ULocalPlayer* GetBenchmarkPlayer(UWorld* World)
+{
+	return World ? World->GetFirstLocalPlayerFromController() : NULL;
+}
+
+/** screen points spread over the viewport of the player */
+static void MakeBenchmarkScreenPoints(ULocalPlayer* Player, int32 NumPoints, TArray<FVector2D>& OutPoints)
+{
+	FVector2D ViewportSize(1280.0f, 720.0f);
+	if (Player->ViewportClient)
+	{
+		Player->ViewportClient->GetViewportSize(ViewportSize);
+	}
+
+	FRandomStream Random(NumPoints);
+	OutPoints.SetNumUninitialized(NumPoints);
+	for (int32 i = 0; i < NumPoints; i++)
+	{
+		OutPoints[i] = FVector2D(Random.FRand() * ViewportSize.X, Random.FRand() * ViewportSize.Y);
+	}
+}
+
+static void BenchDeproject(const TArray<FString>& Args, UWorld* World)
+{
+	ULocalPlayer* Player = GetBenchmarkPlayer(World);
+	if (Player == NULL)
+	{
+		return;
+	}
+
+	const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+	TArray<FVector2D> ScreenPoints;
+	MakeBenchmarkScreenPoints(Player, NumPoints, ScreenPoints);
+
+	TArray<FVector> RayOrigins;
+	TArray<FVector> RayDirections;
+	RayOrigins.SetNumUninitialized(NumPoints);
+	RayDirections.SetNumUninitialized(NumPoints);
+
+	// one projection per point, as every pick did before the cache
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumPoints; i++)
+	{
+		FTDCCameraHelpers::InvalidateProjectionCache();
+		FTDCCameraHelpers::DeprojectScreenToWorld(ScreenPoints[i], Player, RayOrigins[i], RayDirections[i]);
+	}
+	const double UncachedTime = FPlatformTime::Seconds() - StartTime;
+
+	// one projection for the whole batch
+	FTDCCameraHelpers::InvalidateProjectionCache();
+	StartTime = FPlatformTime::Seconds();
+	FTDCCameraHelpers::DeprojectScreenToWorldBatch(ScreenPoints, Player, RayOrigins, RayDirections);
+	const double BatchTime = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Display, TEXT("TDC.BenchDeproject %d points: uncached %.1f ns/point, cached batch %.1f ns/point"),
+		NumPoints, UncachedTime * 1e9 / NumPoints, BatchTime * 1e9 / NumPoints);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchDeprojectCommand(
+	TEXT("TDC.BenchDeproject"),
+	TEXT("Times per point deprojection against the cached batch deprojection. Usage: TDC.BenchDeproject [NumPoints]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchDeproject));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Automation tests of the camera and input hot paths. Run them headless with
+ * UE4Editor <Project> -game -nullrhi -unattended -ExecCmds="Automation RunTests TDC; Quit"
+ * The benchmarks write ns/op to Saved/Profiling/TDCBench<Suite>.csv and fail on a regression against
+ * Config/TDCBenchBaseline<Suite>.csv, or the file given with -TDCBenchBaseline<Suite>=<file>. The baseline is a report
+ * of a run on the reference machine; without one the report is only written.
+ */
+
+/** relative time over the baseline tolerated */
+static const double BenchTimeTolerance = 0.25;
+
+/** calls of the timed functions per benchmark */
+static const int32 BenchNumOps = 10000;
+
+/** one line of the benchmark report */
+struct FTDCBenchResult
+{
+	FString Name;
+	double NsPerOp;
+};
+
+/** time NumOps calls of Function(OpIndex) */
+template<typename FunctionType>
+static FTDCBenchResult RunBenchmark(const TCHAR* Name, int32 NumOps, FunctionType Function)
+{
+	// warm up caches and lazily built state
+	Function(0);
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumOps; i++)
+	{
+		Function(i);
+	}
+	const double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	FTDCBenchResult Result;
+	Result.Name = Name;
+	Result.NsPerOp = ElapsedTime * 1e9 / NumOps;
+	return Result;
+}
+
+/** read a benchmark report or the baseline */
+static bool LoadBenchResults(const FString& Filename, TMap<FString, FTDCBenchResult>& OutResults)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		return false;
+	}
+
+	// skip the header
+	for (int32 LineIndex = 1; LineIndex < Lines.Num(); LineIndex++)
+	{
+		TArray<FString> Fields;
+		if (Lines[LineIndex].ParseIntoArray(Fields, TEXT(",")) == 2)
+		{
+			FTDCBenchResult& Result = OutResults.Add(Fields[0]);
+			Result.Name = Fields[0];
+			Result.NsPerOp = FCString::Atod(*Fields[1]);
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Write the report of a suite and compare it with the baseline.
+ *
+ * @param	Test		Test the regressions are reported on as errors.
+ * @param	SuiteName	Name of the report and baseline files.
+ * @param	Results		Results of the suite.
+ * @returns	false if a result regressed or has no line in the baseline
+ */
+static bool CheckBenchResults(FAutomationTestBase& Test, const TCHAR* SuiteName, const TArray<FTDCBenchResult>& Results)
+{
+	FString Report = TEXT("Name,NsPerOp\n");
+	for (const FTDCBenchResult& Result : Results)
+	{
+		Report += FString::Printf(TEXT("%s,%.2f\n"), *Result.Name, Result.NsPerOp);
+	}
+	const FString ReportFilename = FPaths::ProfilingDir() / FString::Printf(TEXT("TDCBench%s.csv"), SuiteName);
+	FFileHelper::SaveStringToFile(Report, *ReportFilename);
+
+	FString BaselineFilename = FPaths::ProjectConfigDir() / FString::Printf(TEXT("TDCBenchBaseline%s.csv"), SuiteName);
+	FParse::Value(FCommandLine::Get(), *FString::Printf(TEXT("-TDCBenchBaseline%s="), SuiteName), BaselineFilename);
+
+	// only a measured baseline gates, there is nothing to compare with until a reference run is checked in
+	TMap<FString, FTDCBenchResult> Baseline;
+	if (!LoadBenchResults(BaselineFilename, Baseline))
+	{
+		Test.AddWarning(FString::Printf(TEXT("No benchmark baseline at %s, check in %s from a run on the reference machine"), *BaselineFilename, *ReportFilename));
+		for (const FTDCBenchResult& Result : Results)
+		{
+			Test.AddInfo(FString::Printf(TEXT("%s: %.2f ns/op"), *Result.Name, Result.NsPerOp));
+		}
+		return true;
+	}
+
+	bool bPassed = true;
+	for (const FTDCBenchResult& Result : Results)
+	{
+		const FTDCBenchResult* BaselineResult = Baseline.Find(Result.Name);
+		if (BaselineResult == NULL)
+		{
+			Test.AddError(FString::Printf(TEXT("%s has no baseline in %s, add the line from %s"), *Result.Name, *BaselineFilename, *ReportFilename));
+			bPassed = false;
+		}
+		else if (Result.NsPerOp > BaselineResult->NsPerOp * (1.0 + BenchTimeTolerance))
+		{
+			Test.AddError(FString::Printf(TEXT("%s regressed: %.2f ns/op (baseline %.2f)"), *Result.Name, Result.NsPerOp, BaselineResult->NsPerOp));
+			bPassed = false;
+		}
+		else
+		{
+			Test.AddInfo(FString::Printf(TEXT("%s: %.2f ns/op"), *Result.Name, Result.NsPerOp));
+		}
+	}
+
+	return bPassed;
+}
+
+/** top down rays, always pointing at the ground */
+static void MakeBenchmarkRays(int32 NumRays, FTDCRayBatch& OutRays)
+{
+	FRandomStream Random(NumRays);
+	OutRays.SetNumUninitialized(NumRays);
+	for (int32 i = 0; i < NumRays; i++)
+	{
+		const FVector RayOrigin(Random.FRandRange(-50000.0f, 50000.0f), Random.FRandRange(-50000.0f, 50000.0f), Random.FRandRange(500.0f, 10000.0f));
+		const FVector RayDirection = FVector(Random.FRandRange(-0.5f, 0.5f), Random.FRandRange(-0.5f, 0.5f), -1.0f).GetSafeNormal();
+		OutRays.SetRay(i, RayOrigin, RayDirection);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTDCRayPlaneParityTest, "TDC.Camera.RayPlaneBatchParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTDCRayPlaneParityTest::RunTest(const FString& Parameters)
+{
+	const FPlane GroundPlane(FVector(0.0f, 0.0f, 100.0f), FVector::UpVector);
+
+	// full vectors, a remainder, and the sizes the benchmarks use
+	static const int32 RayCounts[] = { 1, 3, 4, 5, 1003, 10000, 100000 };
+	for (int32 NumRays : RayCounts)
+	{
+		FTDCRayBatch Rays;
+		MakeBenchmarkRays(NumRays, Rays);
+
+		FTDCPointBatch BatchPoints;
+		FTDCCameraHelpers::IntersectRaysWithPlane(Rays, GroundPlane, BatchPoints);
+		if (!TestEqual(FString::Printf(TEXT("Number of points for %d rays"), NumRays), BatchPoints.Num(), NumRays))
+		{
+			continue;
+		}
+
+		// the vector kernel uses a reciprocal instead of a division, compare relative to the ray length
+		float MaxError = 0.0f;
+		for (int32 i = 0; i < NumRays; i++)
+		{
+			const FVector RayOrigin(Rays.OriginX[i], Rays.OriginY[i], Rays.OriginZ[i]);
+			const FVector ScalarPoint = FTDCCameraHelpers::IntersectRayWithPlane(RayOrigin,
+				FVector(Rays.DirectionX[i], Rays.DirectionY[i], Rays.DirectionZ[i]), GroundPlane);
+			const float RayLength = (ScalarPoint - RayOrigin).Size();
+			MaxError = FMath::Max(MaxError, (ScalarPoint - BatchPoints.GetPoint(i)).Size() / FMath::Max(RayLength, 1.0f));
+		}
+
+		TestTrue(FString::Printf(TEXT("Batch matches scalar for %d rays (max relative error %g)"), NumRays, MaxError), MaxError <= KINDA_SMALL_NUMBER);
+	}
+
+	return !HasAnyErrors();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTDCRayPlaneBenchmarkTest, "TDC.Benchmarks.RayPlane",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FTDCRayPlaneBenchmarkTest::RunTest(const FString& Parameters)
+{
+	const FPlane GroundPlane(FVector(0.0f, 0.0f, 0.0f), FVector::UpVector);
+	TArray<FTDCBenchResult> Results;
+
+	// one op is one ray
+	static const int32 RayCounts[] = { 1000, 10000, 100000 };
+	for (int32 NumRays : RayCounts)
+	{
+		FTDCRayBatch Rays;
+		MakeBenchmarkRays(NumRays, Rays);
+		const int32 NumPasses = FMath::Max(1000000 / NumRays, 1);
+
+		FVector GroundPoint(0.0f);
+		FTDCBenchResult ScalarResult = RunBenchmark(*FString::Printf(TEXT("IntersectRayWithPlane%dk"), NumRays / 1000), NumPasses, [&](int32 OpIndex)
+		{
+			for (int32 i = 0; i < NumRays; i++)
+			{
+				GroundPoint += FTDCCameraHelpers::IntersectRayWithPlane(FVector(Rays.OriginX[i], Rays.OriginY[i], Rays.OriginZ[i]),
+					FVector(Rays.DirectionX[i], Rays.DirectionY[i], Rays.DirectionZ[i]), GroundPlane);
+			}
+		});
+
+		FTDCPointBatch BatchPoints;
+		FTDCBenchResult BatchResult = RunBenchmark(*FString::Printf(TEXT("IntersectRaysWithPlane%dk"), NumRays / 1000), NumPasses, [&](int32 OpIndex)
+		{
+			FTDCCameraHelpers::IntersectRaysWithPlane(Rays, GroundPlane, BatchPoints);
+		});
+
+		for (FTDCBenchResult* Result : { &ScalarResult, &BatchResult })
+		{
+			Result->NsPerOp /= NumRays;
+			Results.Add(*Result);
+		}
+	}
+
+	return CheckBenchResults(*this, TEXT("RayPlane"), Results);
+}
+
+/** synthetic touch stream, cycling through a one point drag, a two points pinch, a three points swipe and no touch */
+static void SetSyntheticTouches(FVector* Touches, int32 OpIndex, const FVector2D& Center)
+{
+	const int32 Phase = OpIndex % 120;
+	const int32 NumDown = Phase < 40 ? 1 : Phase < 80 ? 2 : Phase < 100 ? 3 : 0;
+	for (int32 i = 0; i < EKeys::NUM_TOUCH_KEYS; i++)
+	{
+		if (i < NumDown)
+		{
+			const float Offset = (Phase % 40) * 4.0f * (i + 1);
+			Touches[i] = FVector(Center.X + Offset, Center.Y + i * 50.0f, 1.0f);
+		}
+		else
+		{
+			Touches[i].Z = 0.0f;
+		}
+	}
+}
+
+/** synthetic touch events of one frame: a one point drag at 240 Hz, four events per frame, released every second */
+static void AddSyntheticTouchSamples(UTDCInput* Input, int32 OpIndex, const FVector2D& Center)
+{
+	const int32 Phase = OpIndex % 60;
+	for (int32 i = 0; i < 4; i++)
+	{
+		const ETouchType::Type Type = (Phase == 0 && i == 0) ? ETouchType::Began : (Phase == 59 && i == 3) ? ETouchType::Ended : ETouchType::Moved;
+		const double Timestamp = (OpIndex + i * 0.25) / 60.0;
+		Input->AddTouchSample(0, Type, Center + FVector2D(Phase * 4 + i, 0.0f), Timestamp);
+	}
+}
+
+/** the player controller of a running game with the top down camera */
+static ATDCPlayerController* FindBenchmarkController()
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		UWorld* const World = Context.World();
+		if (World && (Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE))
+		{
+			ATDCPlayerController* const Controller = Cast<ATDCPlayerController>(World->GetFirstPlayerController());
+			if (Controller && Controller->GetCameraComponent() && Controller->PlayerInput && GetBenchmarkPlayer(World))
+			{
+				return Controller;
+			}
+		}
+	}
+	return NULL;
+}
+
+/** time the camera and input hot paths of a running game */
+static bool RunCameraBenchmarks(FAutomationTestBase& Test, ATDCPlayerController* Controller)
+{
+	UWorld* const World = Controller->GetWorld();
+	UTDCCameraComponent* const CameraComponent = Controller->GetCameraComponent();
+	ULocalPlayer* const Player = GetBenchmarkPlayer(World);
+
+	TArray<FVector2D> ScreenPoints;
+	MakeBenchmarkScreenPoints(Player, 256, ScreenPoints);
+
+	FVector2D ViewportCenter(640.0f, 360.0f);
+	if (Player->ViewportClient)
+	{
+		Player->ViewportClient->GetViewportSize(ViewportCenter);
+		ViewportCenter *= 0.5f;
+	}
+
+	AActor* const CameraOwner = CameraComponent->GetOwner();
+	const FVector SavedCameraLocation = CameraOwner->GetActorLocation();
+
+	TArray<FTDCBenchResult> Results;
+
+	FMinimalViewInfo ViewInfo;
+	Results.Add(RunBenchmark(TEXT("GetCameraView"), BenchNumOps, [&](int32 OpIndex)
+	{
+		CameraComponent->GetCameraView(1.0f / 60.0f, ViewInfo);
+	}));
+
+	Results.Add(RunBenchmark(TEXT("UpdateCameraMovement"), BenchNumOps, [&](int32 OpIndex)
+	{
+		CameraComponent->UpdateCameraMovement(Controller);
+	}));
+
+	Results.Add(RunBenchmark(TEXT("ClampCameraLocation"), BenchNumOps, [&](int32 OpIndex)
+	{
+		FVector Location = SavedCameraLocation + FVector(OpIndex % 100, OpIndex % 37, 0.0f) * 100.0f;
+		CameraComponent->ClampCameraLocation(Controller, Location);
+	}));
+
+	// a new swipe every 64 updates
+	Results.Add(RunBenchmark(TEXT("Swipe"), BenchNumOps, [&](int32 OpIndex)
+	{
+		const FVector2D& SwipePosition = ScreenPoints[OpIndex % ScreenPoints.Num()];
+		if (OpIndex % 64 == 0)
+		{
+			CameraComponent->OnSwipeReleased(SwipePosition);
+			CameraComponent->OnSwipeStarted(SwipePosition);
+		}
+		CameraComponent->OnSwipeUpdate(SwipePosition);
+	}));
+	CameraComponent->EndSwipeNow();
+
+	// detection without bindings, fed through the player input as the game does before touch events arrive
+	UTDCInput* BenchInput = NewObject<UTDCInput>(Controller);
+	FVector SavedTouches[EKeys::NUM_TOUCH_KEYS];
+	FMemory::Memcpy(SavedTouches, Controller->PlayerInput->Touches, sizeof(SavedTouches));
+	Results.Add(RunBenchmark(TEXT("UpdateDetection"), BenchNumOps, [&](int32 OpIndex)
+	{
+		SetSyntheticTouches(Controller->PlayerInput->Touches, OpIndex, ViewportCenter);
+		BenchInput->UpdateDetection(1.0f / 60.0f, OpIndex / 60.0);
+	}));
+	FMemory::Memcpy(Controller->PlayerInput->Touches, SavedTouches, sizeof(SavedTouches));
+	BenchInput->MarkPendingKill();
+
+	// detection on timestamped touch events, as the game does once they arrive
+	BenchInput = NewObject<UTDCInput>(Controller);
+	Results.Add(RunBenchmark(TEXT("UpdateDetectionTouchSamples"), BenchNumOps, [&](int32 OpIndex)
+	{
+		AddSyntheticTouchSamples(BenchInput, OpIndex, ViewportCenter);
+		BenchInput->UpdateDetection(1.0f / 60.0f, (OpIndex + 1) / 60.0);
+	}));
+	BenchInput->MarkPendingKill();
+
+	TArray<FVector> RayOrigins;
+	TArray<FVector> RayDirections;
+	Results.Add(RunBenchmark(TEXT("DeprojectScreenToWorldBatch256"), BenchNumOps / 100, [&](int32 OpIndex)
+	{
+		FTDCCameraHelpers::DeprojectScreenToWorldBatch(ScreenPoints, Player, RayOrigins, RayDirections);
+	}));
+
+	const FPlane GroundPlane(FVector::ZeroVector, FVector::UpVector);
+	FTDCRayBatch GroundRays;
+	FTDCPointBatch GroundPoints;
+	Results.Add(RunBenchmark(TEXT("DeprojectScreenToGroundBatch256"), BenchNumOps / 100, [&](int32 OpIndex)
+	{
+		FTDCCameraHelpers::DeprojectScreenToGroundBatch(ScreenPoints, Player, GroundPlane, GroundRays, GroundPoints);
+	}));
+
+	// a camera frame with the camera boom and with the lightweight camera rig, as TDC.BenchCameraRig
+	ATDCSpectatorPawn* const SpectatorPawn = Cast<ATDCSpectatorPawn>(Controller->GetSpectatorPawn());
+	if (SpectatorPawn)
+	{
+		USpringArmComponent* const CameraBoom = SpectatorPawn->GetCameraBoomComponent();
+		const bool bWasLightweight = SpectatorPawn->IsLightweightCameraRig();
+
+		SpectatorPawn->SetLightweightCameraRig(false);
+		Results.Add(RunBenchmark(TEXT("CameraFrameBoom"), BenchNumOps, [&](int32 OpIndex)
+		{
+			CameraBoom->TickComponent(1.0f / 60.0f, LEVELTICK_All, &CameraBoom->PrimaryComponentTick);
+			CameraComponent->GetCameraView(1.0f / 60.0f, ViewInfo);
+		}));
+
+		SpectatorPawn->SetLightweightCameraRig(true);
+		Results.Add(RunBenchmark(TEXT("CameraFrameLightweight"), BenchNumOps, [&](int32 OpIndex)
+		{
+			CameraComponent->GetCameraView(1.0f / 60.0f, ViewInfo);
+		}));
+
+		SpectatorPawn->SetLightweightCameraRig(bWasLightweight);
+	}
+
+	CameraOwner->SetActorLocation(SavedCameraLocation);
+
+	return CheckBenchResults(Test, TEXT("CameraAndInput"), Results);
+}
+
+/** wait for the game to run the top down camera, then benchmark it */
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FTDCRunCameraBenchmarksCommand, FAutomationTestBase*, Test, double, StartTime);
+
+bool FTDCRunCameraBenchmarksCommand::Update()
+{
+	// how long the map has to start
+	const double MaxWaitTime = 30.0;
+
+	ATDCPlayerController* const Controller = FindBenchmarkController();
+	if (Controller == NULL)
+	{
+		if (FPlatformTime::Seconds() - StartTime < MaxWaitTime)
+		{
+			return false;
+		}
+
+		Test->AddError(TEXT("The camera benchmarks need a running game with the top down camera, run them with -game"));
+		return true;
+	}
+
+	RunCameraBenchmarks(*Test, Controller);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTDCCameraBenchmarkTest, "TDC.Benchmarks.CameraAndInput",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FTDCCameraBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// the game may still be loading its map when the tests start
+	ATDCPlayerController* const Controller = FindBenchmarkController();
+	if (Controller)
+	{
+		return RunCameraBenchmarks(*this, Controller);
+	}
+
+	ADD_LATENT_AUTOMATION_COMMAND(FTDCRunCameraBenchmarksCommand(this, FPlatformTime::Seconds()));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
+
+static void BenchSelection(const TArray<FString>& Args, UWorld* World)
+{
+	ATDCPlayerController* const Controller = Cast<ATDCPlayerController>(World ? World->GetFirstPlayerController() : NULL);
+	ULocalPlayer* const Player = GetBenchmarkPlayer(World);
+	if (Controller == NULL || Player == NULL || Player->ViewportClient == NULL)
+	{
+		return;
+	}
+
+	FVector2D ViewportSize;
+	Player->ViewportClient->GetViewportSize(ViewportSize);
+
+	const int32 NumQueries = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+	TArray<AActor*> SelectedActors;
+
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumQueries; i++)
+	{
+		Controller->SelectActorsInScreenRect(FVector2D::ZeroVector, ViewportSize, SelectedActors);
+	}
+	const double MarqueeTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumQueries; i++)
+	{
+		Controller->PickSelectableActor(ViewportSize * 0.5f);
+	}
+	const double TapTime = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogTemp, Display, TEXT("TDC.BenchSelection %d selectable actors: full screen marquee %.2f us (%d selected), tap %.2f us"),
+		FTDCSelectionIndex::Get(World).Num(), MarqueeTime * 1e6 / NumQueries, SelectedActors.Num(), TapTime * 1e6 / NumQueries);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchSelectionCommand(
+	TEXT("TDC.BenchSelection"),
+	TEXT("Times marquee selection over the whole screen and tap picking through the selection index. Usage: TDC.BenchSelection [NumQueries]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchSelection));
+
+static void BenchCameraRig(const TArray<FString>& Args, UWorld* World)
+{
+	APlayerController* const Controller = World ? World->GetFirstPlayerController() : NULL;
+	ATDCSpectatorPawn* const SpectatorPawn = Controller ? Cast<ATDCSpectatorPawn>(Controller->GetSpectatorPawn()) : NULL;
+	if (SpectatorPawn == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("TDC.BenchCameraRig needs a running game with the top down camera"));
+		return;
+	}
+
+	const int32 NumFrames = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+	const float DeltaTime = 1.0f / 60.0f;
+	UTDCCameraComponent* const CameraComponent = SpectatorPawn->GetCameraComponent();
+	USpringArmComponent* const CameraBoom = SpectatorPawn->GetCameraBoomComponent();
+	const bool bWasLightweight = SpectatorPawn->IsLightweightCameraRig();
+	FMinimalViewInfo ViewInfo;
+
+	// the boom sweeps and lags every frame, then the camera component overrides its view
+	SpectatorPawn->SetLightweightCameraRig(false);
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumFrames; i++)
+	{
+		CameraBoom->TickComponent(DeltaTime, LEVELTICK_All, &CameraBoom->PrimaryComponentTick);
+		CameraComponent->GetCameraView(DeltaTime, ViewInfo);
+	}
+	const double BoomTime = FPlatformTime::Seconds() - StartTime;
+
+	// the camera component alone, smoothing included
+	SpectatorPawn->SetLightweightCameraRig(true);
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumFrames; i++)
+	{
+		CameraComponent->GetCameraView(DeltaTime, ViewInfo);
+	}
+	const double LightweightTime = FPlatformTime::Seconds() - StartTime;
+
+	SpectatorPawn->SetLightweightCameraRig(bWasLightweight);
+
+	UE_LOG(LogTemp, Display, TEXT("TDC.BenchCameraRig %d frames: camera boom %.2f us/frame, lightweight rig %.2f us/frame, %.2f us/frame saved"),
+		NumFrames, BoomTime * 1e6 / NumFrames, LightweightTime * 1e6 / NumFrames, (BoomTime - LightweightTime) * 1e6 / NumFrames);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchCameraRigCommand(
+	TEXT("TDC.BenchCameraRig"),
+	TEXT("Times a camera frame with the camera boom and with the lightweight camera rig. Usage: TDC.BenchCameraRig [NumFrames]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchCameraRig));
@@ -3,15 +3,71 @@
 #include "UE4TopDownCamera.h"
 #include "TDCInput.h"
 #include "TDCCameraHelpers.h"
-#include "TDCSpectatorPawnMovement.h"
+#include "TDCStats.h"
+#include "TDCInputRecorder.h"
+#include "TDCHeightfield.h"
+#include "Engine/LevelBounds.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
 #include "TDCCameraComponent.h"
 
+/** Horizontal field of view of the camera. */
+static const float TopDownCameraFOV = 30.f;
+
+/** How close, in world units, the follow gets to the focal location before it snaps to it. */
+static const float FollowSnapDistance = 0.1f;
+
+/** How far, in world units, the focal location moves before the view is considered changed. */
+static const float ViewLocationTolerance = 0.01f;
+
 UTDCCameraComponent::UTDCCameraComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	// the default Zoom is hardcoded...because at the time this constructor is called we don't have the values from the DefaultGame.ini yet
 	ZoomAlpha = 0.4f; 
 	StartSwipeCoords.Set(0.0f, 0.0f, 0.0f);
+	SwipeGroundPlane = FPlane(FVector::UpVector, 0.0f);
+	PanTracesInWindow = 0;
+	PanIntersectionsInWindow = 0;
+	PanStatsWindowStart = 0.0;
+	CameraMovementBounds.Init();
+	CameraMovementViewportSize = FVector2D::ZeroVector;
+	bCameraBoundsDirty = true;
+	bPlayableBoundsDirty = true;
+	PlayableBounds.Init();
+	bEdgeScrollViewDirty = true;
+	EdgeScrollBands = 0;
+	EdgeScrollDefaultSpeed = 0.0f;
+	FollowLagSpeed = 4.0f;
+	FollowLocation = FVector::ZeroVector;
+	bHasFollowLocation = false;
+	ViewAngle = FRotator::ZeroRotator;
+	ViewZoomAlpha = 0.0f;
+	ViewOffset = FVector::ZeroVector;
+	ViewAspectRatio = 1.0f;
+	ViewFocalLocation = FVector::ZeroVector;
+	ViewLocation = FVector::ZeroVector;
+	bHasViewFootprint = false;
+	bViewOffsetDirty = true;
+}
+
+void UTDCCameraComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UTDCCameraComponent::OnLevelsChanged);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UTDCCameraComponent::OnLevelsChanged);
+	ViewportResizedHandle = FViewport::ViewportResizedEvent.AddUObject(this, &UTDCCameraComponent::OnViewportResized);
+	bCameraBoundsDirty = true;
+	bPlayableBoundsDirty = true;
+}
+
+void UTDCCameraComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	FViewport::ViewportResizedEvent.Remove(ViewportResizedHandle);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UTDCCameraComponent::OnZoomIn()
@@ -29,100 +85,270 @@ void UTDCCameraComponent::GetCameraView(float DeltaTime, FMinimalViewInfo& OutRe
 	APlayerController* Controller = GetPlayerController();
 	if( Controller ) 
 	{
-		OutResult.FOV = 30.f;
-		const float CurrentOffset = MinCameraOffset + ZoomAlpha * (MaxCameraOffset - MinCameraOffset);
-		FVector Pos2 = Controller->GetFocalLocation();
-		OutResult.Location = Controller->GetFocalLocation() - FixedCameraAngle.Vector() * CurrentOffset;
-		OutResult.Rotation = FixedCameraAngle;
+		const double StartTime = FPlatformTime::Seconds();
+
+		// the offset only changes with the angle and the zoom, the location only when the focal location moves
+		bool bViewChanged = false;
+		if (bViewOffsetDirty || FixedCameraAngle != ViewAngle || ZoomAlpha != ViewZoomAlpha)
+		{
+			UpdateViewOffset(Controller);
+			bViewChanged = true;
+		}
+
+		const FVector FocalLocation = GetFollowLocation(Controller->GetFocalLocation(), DeltaTime);
+		if (bViewChanged || !FocalLocation.Equals(ViewFocalLocation, ViewLocationTolerance))
+		{
+			ViewFocalLocation = FocalLocation;
+			ViewLocation = FocalLocation + ViewOffset;
+			bViewChanged = true;
+		}
+
+		OutResult.FOV = TopDownCameraFOV;
+		OutResult.Location = ViewLocation;
+		OutResult.Rotation = ViewAngle;
+
+		if (bViewChanged)
+		{
+			bHasViewFootprint = ComputeViewFootprint(OutResult, ViewFootprint);
+			if (bHasViewFootprint)
+			{
+				OnCameraViewChanged.Broadcast(OutResult, ViewFootprint);
+				OnViewChanged.Broadcast(OutResult.Location, OutResult.Rotation);
+			}
+		}
+
+		FTDCInputRecorder::Get().AddCameraTime(FPlatformTime::Seconds() - StartTime);
+	}
+}
+
+FVector UTDCCameraComponent::GetFollowLocation( const FVector& FocalLocation, float DeltaTime )
+{
+	// a swipe keeps the ground point under the finger, a lagging view would overshoot it
+	const bool bSwiping = !StartSwipeCoords.IsNearlyZero();
+	if (FollowLagSpeed <= 0.0f || !bHasFollowLocation || bSwiping)
+	{
+		FollowLocation = FocalLocation;
+		bHasFollowLocation = true;
+		return FollowLocation;
+	}
+
+	// exponential decay towards the focal location, the same follow at any frame rate
+	FollowLocation = FocalLocation + (FollowLocation - FocalLocation) * FMath::Exp(-FollowLagSpeed * DeltaTime);
+
+	// the decay never gets there, snap once it is close enough for the view to settle
+	if (FVector::DistSquared(FollowLocation, FocalLocation) <= FMath::Square(FollowSnapDistance))
+	{
+		FollowLocation = FocalLocation;
 	}
+	return FollowLocation;
+}
+
+void UTDCCameraComponent::UpdateViewOffset( const APlayerController* InPlayerController )
+{
+	ViewAngle = FixedCameraAngle;
+	ViewZoomAlpha = ZoomAlpha;
+	ViewOffset = -FixedCameraAngle.Vector() * (MinCameraOffset + ZoomAlpha * (MaxCameraOffset - MinCameraOffset));
+
+	// the player's part of the viewport, kept until the viewport is resized
+	const ULocalPlayer* const LocalPlayer = Cast<ULocalPlayer>(InPlayerController->Player);
+	FVector2D ViewportSize;
+	if (LocalPlayer && LocalPlayer->ViewportClient)
+	{
+		LocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+		const FVector2D ViewSize = ViewportSize * LocalPlayer->Size;
+		if (ViewSize.X > 0.0f && ViewSize.Y > 0.0f)
+		{
+			ViewAspectRatio = ViewSize.X / ViewSize.Y;
+			bViewOffsetDirty = false;
+		}
+	}
+}
+
+bool UTDCCameraComponent::ComputeViewFootprint( const FMinimalViewInfo& View, FTDCCameraFootprint& OutFootprint ) const
+{
+	// the field of view is horizontal
+	const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(View.FOV * 0.5f));
+	const float TanHalfVerticalFOV = TanHalfFOV / ViewAspectRatio;
+	const FRotationMatrix ViewRotation(View.Rotation);
+
+	// top left, top right, bottom right, bottom left as on screen
+	static const float CornerSigns[4][2] = { { -1.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f } };
+	for (int32 i = 0; i < 4; i++)
+	{
+		const FVector Direction = ViewRotation.TransformVector(FVector(1.0f, CornerSigns[i][0] * TanHalfFOV, CornerSigns[i][1] * TanHalfVerticalFOV));
+		if (Direction.Z > -KINDA_SMALL_NUMBER)
+		{
+			return false;
+		}
+
+		OutFootprint.Corners[i] = FVector2D(View.Location + Direction * ((PanGroundPlaneHeight - View.Location.Z) / Direction.Z));
+	}
+	return true;
+}
+
+void UTDCCameraComponent::ResetFollow()
+{
+	bHasFollowLocation = false;
 }
 
 void UTDCCameraComponent::UpdateCameraMovement( const APlayerController* InPlayerController )
 {
 	// No mouse support on mobile
 #if PLATFORM_DESKTOP
-	ULocalPlayer* const LocalPlayer =  Cast<ULocalPlayer>(InPlayerController->Player);
+	ULocalPlayer* LocalPlayer = EdgeScrollPlayer.Get();
+	if (LocalPlayer == NULL || LocalPlayer->PlayerController != InPlayerController)
+	{
+		LocalPlayer = Cast<ULocalPlayer>(InPlayerController->Player);
+		EdgeScrollPlayer = LocalPlayer;
+		bEdgeScrollViewDirty = true;
+	}
+
 	if (LocalPlayer && LocalPlayer->ViewportClient && LocalPlayer->ViewportClient->Viewport )
 	{
+		FTDCInputRecorder& InputRecorder = FTDCInputRecorder::Get();
+		const double StartTime = FPlatformTime::Seconds();
+
 		FVector2D MousePosition;
-		if (LocalPlayer->ViewportClient->GetMousePosition(MousePosition) == false)
+		FIntPoint ViewportSize;
+		if (InputRecorder.IsReplaying())
 		{
-			return;
-		}
+			// there is no cursor without a window, use the recorded one
+			const FTDCInputFrame& Frame = InputRecorder.GetReplayFrame();
+			if (Frame.bHasMousePosition == false)
+			{
+				return;
+			}
 
-		FViewport* Viewport = LocalPlayer->ViewportClient->Viewport;
-		const float ScrollSpeed = 60.0f;
-		const FIntPoint ViewportSize = Viewport->GetSizeXY();
-		const uint32 ViewLeft = FMath::TruncToInt(LocalPlayer->Origin.X * ViewportSize.X);
-		const uint32 ViewRight = ViewLeft + FMath::TruncToInt(LocalPlayer->Size.X * ViewportSize.X);
-		const uint32 ViewTop = FMath::TruncToInt(LocalPlayer->Origin.Y * ViewportSize.Y);
-		const uint32 ViewBottom = ViewTop + FMath::TruncToInt(LocalPlayer->Size.Y * ViewportSize.Y);
-		
-		const float MaxSpeed = CameraSpeed * FMath::Clamp(ZoomAlpha, MinZoomLevel, MaxZoomLevel);
-
-		bool bNoScrollZone = false;
-		FVector MouseCoords( MousePosition, 0.0f );
-		for (int iZone = 0; iZone < NoScrollZones.Num() ; iZone++)
+			MousePosition = Frame.MousePosition;
+			ViewportSize = Frame.ViewportSize;
+			bEdgeScrollViewDirty = true;
+		}
+		else
 		{
-			FBox EachZone = NoScrollZones[ iZone ];
-			if( EachZone.IsInsideXY( MouseCoords ) == true )
+			if (LocalPlayer->ViewportClient->GetMousePosition(MousePosition) == false)
 			{
-				bNoScrollZone = true;
+				return;
 			}
+
+			ViewportSize = LocalPlayer->ViewportClient->Viewport->GetSizeXY();
 		}
 
-		const uint32 MouseX = MousePosition.X;
-		const uint32 MouseY = MousePosition.Y;
-		float SpectatorCameraSpeed = MaxSpeed;
-		ASpectatorPawn* SpectatorPawn = NULL;
-		if( GetPlayerController() != NULL )
+		if (bEdgeScrollViewDirty)
 		{
-			SpectatorPawn = GetPlayerController()->GetSpectatorPawn();
-			if( SpectatorPawn->GetMovementComponent() != NULL )
-			{
-				SpectatorCameraSpeed = GetDefault<UTDCSpectatorPawnMovement>(SpectatorPawn->GetMovementComponent()->GetClass())->MaxSpeed;
-			}
+			const int32 ViewLeft = FMath::TruncToInt(LocalPlayer->Origin.X * ViewportSize.X);
+			const int32 ViewTop = FMath::TruncToInt(LocalPlayer->Origin.Y * ViewportSize.Y);
+			EdgeScrollViewRect = FIntRect(ViewLeft, ViewTop,
+				ViewLeft + FMath::TruncToInt(LocalPlayer->Size.X * ViewportSize.X),
+				ViewTop + FMath::TruncToInt(LocalPlayer->Size.Y * ViewportSize.Y));
+			bEdgeScrollViewDirty = false;
 		}
-		if (!bNoScrollZone)
+
+		UpdateEdgeScroll(MousePosition);
+		InputRecorder.AddCameraTime(FPlatformTime::Seconds() - StartTime);
+	}
+#endif
+}
+
+void UTDCCameraComponent::UpdateEdgeScroll( const FVector2D& MousePosition )
+{
+	const int32 MouseX = MousePosition.X;
+	const int32 MouseY = MousePosition.Y;
+	const int32 Border = CameraActiveBorder;
+
+	// which border bands is the cursor in?
+	uint8 NewEdgeScrollBands = 0;
+	if (MouseX >= EdgeScrollViewRect.Min.X && MouseX <= EdgeScrollViewRect.Min.X + Border)
+	{
+		NewEdgeScrollBands |= EdgeScrollBand_Left;
+	}
+	else if (MouseX >= EdgeScrollViewRect.Max.X - Border && MouseX <= EdgeScrollViewRect.Max.X)
+	{
+		NewEdgeScrollBands |= EdgeScrollBand_Right;
+	}
+	if (MouseY >= EdgeScrollViewRect.Min.Y && MouseY <= EdgeScrollViewRect.Min.Y + Border)
+	{
+		NewEdgeScrollBands |= EdgeScrollBand_Top;
+	}
+	else if (MouseY >= EdgeScrollViewRect.Max.Y - Border && MouseY <= EdgeScrollViewRect.Max.Y)
+	{
+		NewEdgeScrollBands |= EdgeScrollBand_Bottom;
+	}
+
+	// idle: only restore the default speed when leaving the bands
+	if (NewEdgeScrollBands == 0)
+	{
+		if (EdgeScrollBands != 0)
 		{
-			if (MouseX >= ViewLeft && MouseX <= (ViewLeft + CameraActiveBorder))
-			{
-				const float delta = 1.0f - float(MouseX - ViewLeft) / CameraActiveBorder;
-				SpectatorCameraSpeed = delta * MaxSpeed;
-				MoveRight(-ScrollSpeed * delta);
-			}
-			else if (MouseX >= (ViewRight - CameraActiveBorder) && MouseX <= ViewRight)
-			{
-				const float delta = float(MouseX - ViewRight + CameraActiveBorder) / CameraActiveBorder;
-				SpectatorCameraSpeed = delta * MaxSpeed;
-				MoveRight(ScrollSpeed * delta);
-			}
+			EdgeScrollBands = 0;
+			SetEdgeScrollSpeed(EdgeScrollDefaultSpeed);
+		}
+		return;
+	}
 
-			if (MouseY >= ViewTop && MouseY <= (ViewTop + CameraActiveBorder))
-			{
-				const float delta = 1.0f - float(MouseY - ViewTop) / CameraActiveBorder;
-				SpectatorCameraSpeed = delta * MaxSpeed;
-				MoveForward(ScrollSpeed * delta);
-			}
-			else if (MouseY >= (ViewBottom - CameraActiveBorder) && MouseY <= ViewBottom)
-			{
-				const float delta = float(MouseY - (ViewBottom - CameraActiveBorder)) / CameraActiveBorder;
-				SpectatorCameraSpeed = delta * MaxSpeed;
-				MoveForward(-ScrollSpeed * delta);
-			}
+	if (NoScrollZones.Contains(MousePosition))
+	{
+		return;
+	}
 
-			if( SpectatorPawn != NULL )
-			{
-				UFloatingPawnMovement* PawnMovementComponent = Cast<UFloatingPawnMovement>(SpectatorPawn->GetMovementComponent());
-				if (PawnMovementComponent)
-				{
-					PawnMovementComponent->MaxSpeed = SpectatorCameraSpeed;
-				}
-			}
+	const float ScrollSpeed = 60.0f;
+	const float MaxSpeed = CameraSpeed * FMath::Clamp(ZoomAlpha, MinZoomLevel, MaxZoomLevel);
+	float SpectatorCameraSpeed = MaxSpeed;
+
+	if (NewEdgeScrollBands & EdgeScrollBand_Left)
+	{
+		const float delta = 1.0f - float(MouseX - EdgeScrollViewRect.Min.X) / CameraActiveBorder;
+		SpectatorCameraSpeed = delta * MaxSpeed;
+		MoveRight(-ScrollSpeed * delta);
+	}
+	else if (NewEdgeScrollBands & EdgeScrollBand_Right)
+	{
+		const float delta = float(MouseX - EdgeScrollViewRect.Max.X + Border) / CameraActiveBorder;
+		SpectatorCameraSpeed = delta * MaxSpeed;
+		MoveRight(ScrollSpeed * delta);
+	}
+
+	if (NewEdgeScrollBands & EdgeScrollBand_Top)
+	{
+		const float delta = 1.0f - float(MouseY - EdgeScrollViewRect.Min.Y) / CameraActiveBorder;
+		SpectatorCameraSpeed = delta * MaxSpeed;
+		MoveForward(ScrollSpeed * delta);
+	}
+	else if (NewEdgeScrollBands & EdgeScrollBand_Bottom)
+	{
+		const float delta = float(MouseY - (EdgeScrollViewRect.Max.Y - Border)) / CameraActiveBorder;
+		SpectatorCameraSpeed = delta * MaxSpeed;
+		MoveForward(-ScrollSpeed * delta);
+	}
+
+	EdgeScrollBands = NewEdgeScrollBands;
+	SetEdgeScrollSpeed(SpectatorCameraSpeed);
+}
+
+void UTDCCameraComponent::SetEdgeScrollSpeed( float NewSpeed )
+{
+	UFloatingPawnMovement* PawnMovementComponent = EdgeScrollMovement.Get();
+	if (PawnMovementComponent == NULL)
+	{
+		APawn* OwnerPawn = GetOwnerPawn();
+		PawnMovementComponent = OwnerPawn ? Cast<UFloatingPawnMovement>(OwnerPawn->GetMovementComponent()) : NULL;
+		if (PawnMovementComponent == NULL)
+		{
+			return;
+		}
+
+		EdgeScrollMovement = PawnMovementComponent;
+		EdgeScrollDefaultSpeed = GetDefault<UFloatingPawnMovement>(PawnMovementComponent->GetClass())->MaxSpeed;
+		if (EdgeScrollBands == 0)
+		{
+			NewSpeed = EdgeScrollDefaultSpeed;
 		}
 	}
-#endif
-	NoScrollZones.Empty();
+
+	// only touch the movement component when the speed changes
+	if (PawnMovementComponent->MaxSpeed != NewSpeed)
+	{
+		PawnMovementComponent->MaxSpeed = NewSpeed;
+	}
 }
 
 void UTDCCameraComponent::MoveXYZ(EAxis::Type Axis, float Val)
@@ -143,26 +369,207 @@ void UTDCCameraComponent::MoveXYZ(EAxis::Type Axis, float Val)
 
 }
 
-void UTDCCameraComponent::AddNoScrollZone( FBox InCoords )
+int32 UTDCCameraComponent::AddNoScrollZone( FBox InCoords )
+{
+	return NoScrollZones.Add( InCoords );
+}
+
+bool UTDCCameraComponent::UpdateNoScrollZone( int32 Handle, FBox InCoords )
+{
+	return NoScrollZones.Update( Handle, InCoords );
+}
+
+bool UTDCCameraComponent::RemoveNoScrollZone( int32 Handle )
 {
-	NoScrollZones.AddUnique( InCoords );
+	return NoScrollZones.Remove( Handle );
 }
 
 void UTDCCameraComponent::ClampCameraLocation( const APlayerController* InPlayerController, FVector& OutCameraLocation )
 {	
 	if (bShouldClampCamera)
 	{
-		UpdateCameraBounds(InPlayerController);
-		if (CameraMovementBounds.GetSize() != FVector::ZeroVector)
+		if (bCameraBoundsDirty)
 		{
-			OutCameraLocation = CameraMovementBounds.GetClosestPointTo(OutCameraLocation);
+			UpdateCameraBounds(InPlayerController);
+		}
+		if (CameraMovementBounds.IsValid)
+		{
+			// only the position on the map is clamped, the height is up to the camera
+			OutCameraLocation.X = FMath::Clamp(OutCameraLocation.X, CameraMovementBounds.Min.X, CameraMovementBounds.Max.X);
+			OutCameraLocation.Y = FMath::Clamp(OutCameraLocation.Y, CameraMovementBounds.Min.Y, CameraMovementBounds.Max.Y);
 		}
 	}
 }
 
+bool UTDCCameraComponent::GetViewFootprint( TArray<FVector2D>& OutCorners ) const
+{
+	OutCorners.Reset();
+	if (bHasViewFootprint)
+	{
+		OutCorners.Append(ViewFootprint.Corners, ARRAY_COUNT(ViewFootprint.Corners));
+	}
+	return bHasViewFootprint;
+}
+
+bool UTDCCameraComponent::GetGroundFootprint( const APlayerController* InPlayerController, FVector2D OutCorners[4] )
+{
+	// kept up to date by GetCameraView while the camera moves
+	if (bHasViewFootprint)
+	{
+		for (int32 i = 0; i < 4; i++)
+		{
+			OutCorners[i] = ViewFootprint.Corners[i];
+		}
+		return true;
+	}
+
+	ULocalPlayer* const LocalPlayer = InPlayerController ? Cast<ULocalPlayer>(InPlayerController->Player) : NULL;
+	const FTDCProjectionCache* Projection = LocalPlayer ? FTDCCameraHelpers::GetProjectionCache(LocalPlayer) : NULL;
+	if (Projection == NULL)
+	{
+		return false;
+	}
+
+	// the camera always looks down, every corner of the view hits the ground plane
+	const FIntRect& ViewRect = Projection->ViewRect;
+	FootprintScreenPoints.Reset();
+	FootprintScreenPoints.Add(FVector2D(ViewRect.Min.X, ViewRect.Min.Y));
+	FootprintScreenPoints.Add(FVector2D(ViewRect.Max.X, ViewRect.Min.Y));
+	FootprintScreenPoints.Add(FVector2D(ViewRect.Max.X, ViewRect.Max.Y));
+	FootprintScreenPoints.Add(FVector2D(ViewRect.Min.X, ViewRect.Max.Y));
+
+	const FPlane GroundPlane(FVector(0.0f, 0.0f, PanGroundPlaneHeight), FVector::UpVector);
+	if (!FTDCCameraHelpers::DeprojectScreenToGroundBatch(FootprintScreenPoints, LocalPlayer, GroundPlane, FootprintRays, FootprintGroundPoints))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < 4; i++)
+	{
+		OutCorners[i] = FVector2D(FootprintGroundPoints.GetPoint(i));
+	}
+	return true;
+}
+
 void UTDCCameraComponent::UpdateCameraBounds( const APlayerController* InPlayerController )
 {
-	// this used to do some stuff in the StrategyGame sample for the minimap
+	ULocalPlayer* const LocalPlayer = InPlayerController ? Cast<ULocalPlayer>(InPlayerController->Player) : NULL;
+	if (LocalPlayer == NULL || LocalPlayer->ViewportClient == NULL)
+	{
+		return;
+	}
+
+	FVector2D ViewportSize;
+	LocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+	if (ViewportSize.X <= 0.0f || ViewportSize.Y <= 0.0f)
+	{
+		// wait for the viewport to be created
+		return;
+	}
+
+	bCameraBoundsDirty = false;
+	CameraMovementViewportSize = ViewportSize;
+	CameraMovementBounds.Init();
+
+	// the world is only searched when the levels change, zoom and viewport changes reuse the box
+	if (bPlayableBoundsDirty)
+	{
+		bPlayableBoundsDirty = false;
+		if (GetPlayableBounds(PlayableBounds) == false)
+		{
+			PlayableBounds.Init();
+		}
+	}
+
+	if (!PlayableBounds.IsValid)
+	{
+		return;
+	}
+
+	// half size of the area visible on the ground at the current zoom
+	const float CurrentOffset = MinCameraOffset + ZoomAlpha * (MaxCameraOffset - MinCameraOffset);
+	const float SinPitch = FMath::Max(FMath::Abs(FMath::Sin(FMath::DegreesToRadians(FixedCameraAngle.Pitch))), 0.1f);
+	const float VisibleHalfWidth = CurrentOffset * FMath::Tan(FMath::DegreesToRadians(TopDownCameraFOV * 0.5f));
+	const float VisibleHalfHeight = VisibleHalfWidth * (ViewportSize.Y / ViewportSize.X) / SinPitch;
+
+	// screen axes on the ground
+	const FVector ViewForward = FRotator(0.0f, FixedCameraAngle.Yaw, 0.0f).Vector();
+	const FVector ViewRight(-ViewForward.Y, ViewForward.X, 0.0f);
+	const FVector VisibleExtent(
+		FMath::Abs(ViewForward.X) * VisibleHalfHeight + FMath::Abs(ViewRight.X) * VisibleHalfWidth,
+		FMath::Abs(ViewForward.Y) * VisibleHalfHeight + FMath::Abs(ViewRight.Y) * VisibleHalfWidth,
+		0.0f);
+
+	// keep the visible area inside the part of the map the camera may look at
+	const FVector Center = PlayableBounds.GetCenter();
+	FVector Extent = PlayableBounds.GetExtent() * MiniMapBoundsLimit - VisibleExtent;
+	Extent.X = FMath::Max(Extent.X, 0.0f);
+	Extent.Y = FMath::Max(Extent.Y, 0.0f);
+	Extent.Z = PlayableBounds.GetExtent().Z;
+
+	CameraMovementBounds = FBox(Center - Extent, Center + Extent);
+}
+
+bool UTDCCameraComponent::GetPlayableBounds( FBox& OutBounds ) const
+{
+	UWorld* World = GetWorld();
+	if (World == NULL)
+	{
+		return false;
+	}
+
+	OutBounds.Init();
+
+	// designated camera bounds volumes
+	if (CameraBoundsVolumeTag != NAME_None)
+	{
+		for (TActorIterator<AVolume> It(World); It; ++It)
+		{
+			if (It->ActorHasTag(CameraBoundsVolumeTag))
+			{
+				OutBounds += It->GetComponentsBoundingBox(true);
+			}
+		}
+	}
+
+	// area covered by navigation
+	if (!OutBounds.IsValid)
+	{
+		for (TActorIterator<ANavMeshBoundsVolume> It(World); It; ++It)
+		{
+			OutBounds += It->GetComponentsBoundingBox(true);
+		}
+	}
+
+	// everything in the loaded levels
+	if (!OutBounds.IsValid)
+	{
+		for (ULevel* Level : World->GetLevels())
+		{
+			if (Level && Level->bIsVisible)
+			{
+				OutBounds += Level->LevelBoundsActor.IsValid() ? Level->LevelBoundsActor->GetComponentsBoundingBox(true) : ALevelBounds::CalculateLevelBounds(Level);
+			}
+		}
+	}
+
+	return OutBounds.IsValid && OutBounds.GetSize() != FVector::ZeroVector;
+}
+
+void UTDCCameraComponent::OnLevelsChanged( ULevel* InLevel, UWorld* InWorld )
+{
+	if (InWorld == GetWorld())
+	{
+		bPlayableBoundsDirty = true;
+		bCameraBoundsDirty = true;
+	}
+}
+
+void UTDCCameraComponent::OnViewportResized( FViewport* InViewport, uint32 Unused )
+{
+	bCameraBoundsDirty = true;
+	bEdgeScrollViewDirty = true;
+	bViewOffsetDirty = true;
 }
 
 APlayerController* UTDCCameraComponent::GetPlayerController()
@@ -203,13 +610,31 @@ void UTDCCameraComponent::SetCameraTarget(const FVector& CameraTarget)
 	ASpectatorPawn* SpectatorPawn = GetPlayerController()->GetSpectatorPawn();
 	if( SpectatorPawn != NULL )
 	{
+		TDC_INC_COUNTER(SetActorLocationCalls);
 		SpectatorPawn->SetActorLocation(CameraTarget, false);
 	}	
 }
 
 void UTDCCameraComponent::SetZoomLevel(float NewLevel)
 {
-	ZoomAlpha = FMath::Clamp(NewLevel, MinZoomLevel, MaxZoomLevel);
+	const float NewZoomAlpha = FMath::Clamp(NewLevel, MinZoomLevel, MaxZoomLevel);
+	if (NewZoomAlpha != ZoomAlpha)
+	{
+		ZoomAlpha = NewZoomAlpha;
+		// the visible area changed with the zoom
+		bCameraBoundsDirty = true;
+	}
+}
+
+bool UTDCCameraComponent::SetQuickZoomLevel(int32 PresetIndex)
+{
+	if (!QuickZoomLevels.IsValidIndex(PresetIndex))
+	{
+		return false;
+	}
+
+	SetZoomLevel(QuickZoomLevels[PresetIndex]);
+	return true;
 }
 
 bool UTDCCameraComponent::OnSwipeStarted(const FVector2D& SwipePosition)
@@ -218,16 +643,15 @@ bool UTDCCameraComponent::OnSwipeStarted(const FVector2D& SwipePosition)
 	// Ensure we are NOT trying to start a drag/scroll over a no scroll zone (EG mini map)
 	if (AreCoordsInNoScrollZone(SwipePosition) == false)
 	{
-		APlayerController* Controller = GetPlayerController();
-		if (Controller)
+		// The plane stays the same for the whole swipe/drag
+		SwipeGroundPlane = FPlane(FVector(0.0f, 0.0f, PanGroundPlaneHeight), FVector::UpVector);
+
+		// Get intersection point with the plan used to move around
+		FVector GroundPoint;
+		if (GetSwipeGroundPoint(SwipePosition, GroundPoint))
 		{
-			// Get intersection point with the plan used to move around
-			FHitResult Hit;
-			if (Controller->GetHitResultAtScreenPosition(SwipePosition, COLLISION_PANCAMERA, true, Hit))
-			{
-				StartSwipeCoords = Hit.ImpactPoint;
-				bResult = true;
-			}
+			StartSwipeCoords = GroundPoint;
+			bResult = true;
 		}
 	}
 	else
@@ -240,25 +664,22 @@ bool UTDCCameraComponent::OnSwipeStarted(const FVector2D& SwipePosition)
 bool UTDCCameraComponent::OnSwipeUpdate(const FVector2D& SwipePosition)
 {
 	bool bResult = false;
-	APlayerController* Controller = GetPlayerController();
-	if ((Controller != NULL) && (StartSwipeCoords.IsNearlyZero() == false ) )
+	if (StartSwipeCoords.IsNearlyZero() == false)
 	{
-		FHitResult Hit;
-		if (Controller->GetHitResultAtScreenPosition(SwipePosition, COLLISION_PANCAMERA, true, Hit))
+		FVector NewSwipeCoords;
+		if (GetSwipeGroundPoint(SwipePosition, NewSwipeCoords))
 		{
-			FVector NewSwipeCoords = Hit.ImpactPoint;
 			FVector Delta = StartSwipeCoords - NewSwipeCoords;
 			// Flatten Z axis - we are not interested in that.
 			Delta.Z = 0.0f;
 			if (Delta.IsNearlyZero() == false)
 			{
-				ASpectatorPawn* SpectatorPawn = Cast<ASpectatorPawn>(GetPlayerController()->GetPawn());
+				APawn* SpectatorPawn = GetOwnerPawn();
 				if (SpectatorPawn != NULL)
 				{
-					FVector CurrentCamera = SpectatorPawn->GetActorLocation();
-					CurrentCamera += Delta;
-					SpectatorPawn->SetActorLocation(CurrentCamera);
-					SetCameraTarget(CurrentCamera);
+					// single transform update per swipe update
+					TDC_INC_COUNTER(SetActorLocationCalls);
+					SpectatorPawn->SetActorLocation(SpectatorPawn->GetActorLocation() + Delta, false);
 					bResult = true;
 				}
 			}
@@ -272,20 +693,12 @@ bool UTDCCameraComponent::OnSwipeReleased(const FVector2D& SwipePosition)
 	bool bResult = false;
 	if (StartSwipeCoords.IsNearlyZero() == false)
 	{
-		APlayerController* Controller = GetPlayerController();
-		if (Controller)
-		{
-			FHitResult Hit;
-			if (Controller->GetHitResultAtScreenPosition(SwipePosition, COLLISION_PANCAMERA, true, Hit))
-			{
-				FVector EndSwipeCoords = Hit.ImpactPoint;
-				bResult = true;
-			}
-		}
+		// the camera has already been moved by the updates, nothing to query here
 		EndSwipeNow();
+		bResult = true;
 	}
 
-	return false;
+	return bResult;
 }
 
 void UTDCCameraComponent::EndSwipeNow()
@@ -295,15 +708,78 @@ void UTDCCameraComponent::EndSwipeNow()
 
 bool UTDCCameraComponent::AreCoordsInNoScrollZone(const FVector2D& SwipePosition)
 {
-	bool bResult = false;
-	FVector MouseCoords(SwipePosition, 0.0f);
-	for (int iZone = 0; iZone < NoScrollZones.Num(); iZone++)
+	return NoScrollZones.Contains(SwipePosition);
+}
+
+bool UTDCCameraComponent::GetSwipeGroundPoint(const FVector2D& SwipePosition, FVector& OutGroundPoint)
+{
+	TDC_SCOPE_CYCLE_COUNTER(SwipeGroundQuery);
+
+	APlayerController* Controller = GetPlayerController();
+	if (Controller == NULL)
+	{
+		return false;
+	}
+
+	if (bUsePanTraceFallback)
 	{
-		FBox EachZone = NoScrollZones[iZone];
-		if (EachZone.IsInsideXY(MouseCoords) == true)
+		// baked ground heights first, they cost no physics trace
+		FTDCHeightfieldSampler* const Heightfields = TTDCWorldRegistry<FTDCHeightfieldSampler>::Find(GetWorld());
+		FVector RayOrigin, RayDirection;
+		if (Heightfields && Heightfields->HasData() &&
+			FTDCCameraHelpers::DeprojectScreenToWorld(SwipePosition, Cast<ULocalPlayer>(Controller->Player), RayOrigin, RayDirection) &&
+			Heightfields->Raycast(RayOrigin, RayDirection, OutGroundPoint))
 		{
-			bResult = true;
+			return true;
+		}
+
+		CountPanQuery(true);
+		TDC_INC_COUNTER(PhysicsTraces);
+
+		FHitResult Hit;
+		if (Controller->GetHitResultAtScreenPosition(SwipePosition, COLLISION_PANCAMERA, true, Hit))
+		{
+			OutGroundPoint = Hit.ImpactPoint;
+			return true;
 		}
+		return false;
+	}
+
+	CountPanQuery(false);
+
+	FVector RayOrigin, RayDirection;
+	if (FTDCCameraHelpers::DeprojectScreenToWorld(SwipePosition, Cast<ULocalPlayer>(Controller->Player), RayOrigin, RayDirection))
+	{
+		// ignore rays that never reach the ground
+		if (FVector::DotProduct(RayDirection, SwipeGroundPlane.GetSafeNormal()) < -KINDA_SMALL_NUMBER)
+		{
+			OutGroundPoint = FTDCCameraHelpers::IntersectRayWithPlane(RayOrigin, RayDirection, SwipeGroundPlane);
+			return true;
+		}
+	}
+	return false;
+}
+
+void UTDCCameraComponent::CountPanQuery(bool bPhysicsTrace)
+{
+	if (bPhysicsTrace)
+	{
+		TDC_INC_COUNTER(PanPhysicsTraces);
+		PanTracesInWindow++;
+	}
+	else
+	{
+		TDC_INC_COUNTER(PanPlaneIntersections);
+		PanIntersectionsInWindow++;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - PanStatsWindowStart >= 1.0)
+	{
+		SET_DWORD_STAT(STAT_TDC_PanPhysicsTracesPerSecond, PanTracesInWindow);
+		SET_DWORD_STAT(STAT_TDC_PanPlaneIntersectionsPerSecond, PanIntersectionsInWindow);
+		PanTracesInWindow = 0;
+		PanIntersectionsInWindow = 0;
+		PanStatsWindowStart = Now;
 	}
-	return bResult;
 }
@@ -2,26 +2,92 @@
 #include "UE4TopDownCamera.h"
 #include "TDCCameraHelpers.h"
 
-bool FTDCCameraHelpers::DeprojectScreenToWorld(const FVector2D& ScreenPosition, ULocalPlayer* Player, FVector& RayOrigin, FVector& RayDirection)
+/** projection of the last player deprojected for */
+static FTDCProjectionCache GProjectionCache;
+
+const FTDCProjectionCache* FTDCCameraHelpers::GetProjectionCache(ULocalPlayer* Player)
 {
-	if (Player != NULL && Player->ViewportClient != NULL && Player->ViewportClient->Viewport != NULL && Player->PlayerController != NULL)
+	if (Player == NULL || Player->ViewportClient == NULL || Player->ViewportClient->Viewport == NULL || Player->PlayerController == NULL)
+	{
+		return NULL;
+	}
+
+	FViewport* const Viewport = Player->ViewportClient->Viewport;
+	APlayerCameraManager* const CameraManager = Player->PlayerController->PlayerCameraManager;
+	const FVector ViewLocation = CameraManager ? CameraManager->GetCameraLocation() : FVector::ZeroVector;
+	const FRotator ViewRotation = CameraManager ? CameraManager->GetCameraRotation() : FRotator::ZeroRotator;
+	const float FOV = CameraManager ? CameraManager->GetFOVAngle() : 0.0f;
+	const FIntPoint ViewportSize = Viewport->GetSizeXY();
+
+	const bool bCacheValid = GProjectionCache.Player.Get() == Player
+		&& GProjectionCache.ViewLocation == ViewLocation
+		&& GProjectionCache.ViewRotation == ViewRotation
+		&& GProjectionCache.FOV == FOV
+		&& GProjectionCache.ViewportSize == ViewportSize
+		&& GProjectionCache.PlayerOrigin == Player->Origin
+		&& GProjectionCache.PlayerSize == Player->Size;
+
+	if (!bCacheValid)
 	{
 		//get the projection data
 		FSceneViewProjectionData ProjectionData;
-		if (Player->GetProjectionData(Player->ViewportClient->Viewport, eSSP_FULL, /*out*/ ProjectionData))
+		if (!Player->GetProjectionData(Viewport, eSSP_FULL, /*out*/ ProjectionData))
 		{
-			const FMatrix InvViewMatrix = ProjectionData.ViewRotationMatrix.InverseFast();
-			const FMatrix InvProjectionMatrix = ProjectionData.ProjectionMatrix.InverseFast();
+			InvalidateProjectionCache();
+			return NULL;
+		}
 
-			FSceneView::DeprojectScreenToWorld(ScreenPosition, ProjectionData.GetConstrainedViewRect(), InvViewMatrix, InvProjectionMatrix, /*out*/ RayOrigin, /*out*/ RayDirection);
+		GProjectionCache.Player = Player;
+		GProjectionCache.ViewLocation = ViewLocation;
+		GProjectionCache.ViewRotation = ViewRotation;
+		GProjectionCache.FOV = FOV;
+		GProjectionCache.ViewportSize = ViewportSize;
+		GProjectionCache.PlayerOrigin = Player->Origin;
+		GProjectionCache.PlayerSize = Player->Size;
+		GProjectionCache.ViewRect = ProjectionData.GetConstrainedViewRect();
+		GProjectionCache.InvViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix().InverseFast();
+	}
 
-			return true;
-		}
+	return &GProjectionCache;
+}
+
+void FTDCCameraHelpers::InvalidateProjectionCache()
+{
+	GProjectionCache.Player.Reset();
+}
+
+bool FTDCCameraHelpers::DeprojectScreenToWorld(const FVector2D& ScreenPosition, ULocalPlayer* Player, FVector& RayOrigin, FVector& RayDirection)
+{
+	const FTDCProjectionCache* Projection = GetProjectionCache(Player);
+	if (Projection != NULL)
+	{
+		FSceneView::DeprojectScreenToWorld(ScreenPosition, Projection->ViewRect, Projection->InvViewProjectionMatrix, /*out*/ RayOrigin, /*out*/ RayDirection);
+		return true;
 	}
 
 	return false;
 }
 
+bool FTDCCameraHelpers::DeprojectScreenToWorldBatch(const TArray<FVector2D>& ScreenPositions, ULocalPlayer* Player, TArray<FVector>& RayOrigins, TArray<FVector>& RayDirections)
+{
+	const FTDCProjectionCache* Projection = GetProjectionCache(Player);
+	if (Projection == NULL)
+	{
+		return false;
+	}
+
+	const int32 NumPositions = ScreenPositions.Num();
+	RayOrigins.SetNumUninitialized(NumPositions, false);
+	RayDirections.SetNumUninitialized(NumPositions, false);
+
+	for (int32 i = 0; i < NumPositions; i++)
+	{
+		FSceneView::DeprojectScreenToWorld(ScreenPositions[i], Projection->ViewRect, Projection->InvViewProjectionMatrix, /*out*/ RayOrigins[i], /*out*/ RayDirections[i]);
+	}
+
+	return true;
+}
+
 FVector FTDCCameraHelpers::IntersectRayWithPlane(const FVector& RayOrigin, const FVector& RayDirection, const FPlane& Plane)
 {
 	const FVector PlaneNormal = FVector(Plane.X, Plane.Y, Plane.Z);
@@ -31,6 +97,98 @@ FVector FTDCCameraHelpers::IntersectRayWithPlane(const FVector& RayOrigin, const
 	return RayOrigin + RayDirection * Distance;
 }
 
+void FTDCCameraHelpers::IntersectRaysWithPlane(const FTDCRayBatch& Rays, const FPlane& Plane, FTDCPointBatch& OutPoints)
+{
+	const int32 NumRays = Rays.Num();
+	OutPoints.SetNumUninitialized(NumRays);
+
+	// same terms as IntersectRayWithPlane, evaluated in the same order
+	const VectorRegister NormalX = VectorSetFloat1(Plane.X);
+	const VectorRegister NormalY = VectorSetFloat1(Plane.Y);
+	const VectorRegister NormalZ = VectorSetFloat1(Plane.Z);
+	const VectorRegister PlaneOriginX = VectorSetFloat1(Plane.X * Plane.W);
+	const VectorRegister PlaneOriginY = VectorSetFloat1(Plane.Y * Plane.W);
+	const VectorRegister PlaneOriginZ = VectorSetFloat1(Plane.Z * Plane.W);
+
+	int32 i = 0;
+	for (; i + 4 <= NumRays; i += 4)
+	{
+		const VectorRegister OriginX = VectorLoad(&Rays.OriginX[i]);
+		const VectorRegister OriginY = VectorLoad(&Rays.OriginY[i]);
+		const VectorRegister OriginZ = VectorLoad(&Rays.OriginZ[i]);
+		const VectorRegister DirectionX = VectorLoad(&Rays.DirectionX[i]);
+		const VectorRegister DirectionY = VectorLoad(&Rays.DirectionY[i]);
+		const VectorRegister DirectionZ = VectorLoad(&Rays.DirectionZ[i]);
+
+		VectorRegister Numerator = VectorMultiply(VectorSubtract(PlaneOriginX, OriginX), NormalX);
+		Numerator = VectorMultiplyAdd(VectorSubtract(PlaneOriginY, OriginY), NormalY, Numerator);
+		Numerator = VectorMultiplyAdd(VectorSubtract(PlaneOriginZ, OriginZ), NormalZ, Numerator);
+
+		VectorRegister Denominator = VectorMultiply(DirectionX, NormalX);
+		Denominator = VectorMultiplyAdd(DirectionY, NormalY, Denominator);
+		Denominator = VectorMultiplyAdd(DirectionZ, NormalZ, Denominator);
+
+		const VectorRegister Distance = VectorMultiply(Numerator, VectorReciprocalAccurate(Denominator));
+
+		VectorStore(VectorMultiplyAdd(DirectionX, Distance, OriginX), &OutPoints.X[i]);
+		VectorStore(VectorMultiplyAdd(DirectionY, Distance, OriginY), &OutPoints.Y[i]);
+		VectorStore(VectorMultiplyAdd(DirectionZ, Distance, OriginZ), &OutPoints.Z[i]);
+	}
+
+	// remaining rays
+	for (; i < NumRays; i++)
+	{
+		const FVector Point = IntersectRayWithPlane(
+			FVector(Rays.OriginX[i], Rays.OriginY[i], Rays.OriginZ[i]),
+			FVector(Rays.DirectionX[i], Rays.DirectionY[i], Rays.DirectionZ[i]),
+			Plane);
+		OutPoints.X[i] = Point.X;
+		OutPoints.Y[i] = Point.Y;
+		OutPoints.Z[i] = Point.Z;
+	}
+}
+
+bool FTDCCameraHelpers::DeprojectScreenToGroundBatch(const TArray<FVector2D>& ScreenPositions, ULocalPlayer* Player, const FPlane& GroundPlane, FTDCRayBatch& ScratchRays, FTDCPointBatch& OutPoints)
+{
+	const FTDCProjectionCache* Projection = GetProjectionCache(Player);
+	if (Projection == NULL)
+	{
+		return false;
+	}
+
+	const int32 NumPositions = ScreenPositions.Num();
+	ScratchRays.SetNumUninitialized(NumPositions);
+
+	for (int32 i = 0; i < NumPositions; i++)
+	{
+		FVector RayOrigin, RayDirection;
+		FSceneView::DeprojectScreenToWorld(ScreenPositions[i], Projection->ViewRect, Projection->InvViewProjectionMatrix, /*out*/ RayOrigin, /*out*/ RayDirection);
+		ScratchRays.SetRay(i, RayOrigin, RayDirection);
+	}
+
+	IntersectRaysWithPlane(ScratchRays, GroundPlane, OutPoints);
+	return true;
+}
+
+float FTDCCameraHelpers::GetQuadWinding(const FVector2D Corners[4])
+{
+	return FVector2D::CrossProduct(Corners[1] - Corners[0], Corners[2] - Corners[0]) < 0.0f ? -1.0f : 1.0f;
+}
+
+bool FTDCCameraHelpers::IsInsideConvexQuad(const FVector2D Corners[4], float Winding, const FVector2D& Point)
+{
+	for (int32 i = 0; i < 4; i++)
+	{
+		const FVector2D& EdgeStart = Corners[i];
+		const FVector2D& EdgeEnd = Corners[(i + 1) % 4];
+		if (FVector2D::CrossProduct(EdgeEnd - EdgeStart, Point - EdgeStart) * Winding < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 TSharedPtr<TArray<uint8>> FTDCCameraHelpers::CreateAlphaMapFromTexture(UTexture2D* Texture)
 {
 	TSharedPtr<TArray<uint8>> ResultArray;
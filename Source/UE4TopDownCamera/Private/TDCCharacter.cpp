@@ -2,13 +2,18 @@
 
 #include "UE4TopDownCamera.h"
 #include "TDCCharacter.h"
+#include "TDCSelectionIndex.h"
+#include "TDCSignificanceManager.h"
+#include "TDCPlayerController.h"
 
 // Sets default values
 ATDCCharacter::ATDCCharacter(const class FObjectInitializer& OI)
 	: Super(OI.SetDefaultSubobjectClass<UCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
+	, SelectionHandle(INDEX_NONE)
+	, SignificanceHandle(INDEX_NONE)
 {
-	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Nothing to do per frame: movement and animation tick on their own, at the rate set by the significance manager
+	PrimaryActorTick.bCanEverTick = false;
 
 	static ConstructorHelpers::FObjectFinder<USkeletalMesh> MeshFinder(CHARACTER_MESH);
 	if (MeshFinder.Succeeded())
@@ -25,6 +30,7 @@ ATDCCharacter::ATDCCharacter(const class FObjectInitializer& OI)
 	
 	GetMesh()->SetRelativeRotation(FRotator(0, -90, 0)); // rotate the mesh to match the Arrow component
 	GetMesh()->SetRelativeLocation(FVector(0, 0, -80)); // align the mesh inside the Capsule component
+	GetMesh()->bEnableUpdateRateOptimizations = true; // skip animation updates for characters small on screen
 	
 	// capsule values are based on the demo mesh currently used. Adjust these when the character is finalized
 	GetCapsuleComponent()->SetCapsuleRadius(30.0f);
@@ -40,11 +46,14 @@ ATDCCharacter::ATDCCharacter(const class FObjectInitializer& OI)
 	MoveComp->bCanWalkOffLedgesWhenCrouching = false;
 	MoveComp->MaxWalkSpeedCrouched = 200;
 	MoveComp->bCanWalkOffLedges = false;
+	// face the direction of movement; the AI controller does not tick to turn the character
+	MoveComp->bOrientRotationToMovement = true;
+	MoveComp->RotationRate = FRotator(0.0f, 640.0f, 0.0f);
 
 
-	bUseControllerRotationPitch = true;
-	bUseControllerRotationRoll = true;
-	bUseControllerRotationYaw = true;
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationRoll = false;
+	bUseControllerRotationYaw = false;
 
 	/* Ignore this channel or it will absorb the trace impacts instead of the skeletal mesh */
 	//ntk: GetCapsuleComponent()->SetCollisionResponseToChannel(COLLISION_WEAPON, ECR_Ignore);
@@ -56,18 +65,141 @@ ATDCCharacter::ATDCCharacter(const class FObjectInitializer& OI)
 }
 
 
-// Called every frame
-void ATDCCharacter::Tick(float DeltaTime)
+void ATDCCharacter::BeginPlay()
 {
-	Super::Tick(DeltaTime);
+	Super::BeginPlay();
 
+	// selectable by tap and marquee without physics traces
+	RegisterSelectable();
+
+	RegisterSignificance();
 }
 
 void ATDCCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	UnregisterSelectable();
+
+	UnregisterSignificance();
+
 	Super::EndPlay(EndPlayReason);
 }
 
+void ATDCCharacter::RegisterSelectable()
+{
+	if (SelectionHandle == INDEX_NONE)
+	{
+		SelectionHandle = FTDCSelectionIndex::Get(GetWorld()).Add(this, GetCapsuleComponent()->GetScaledCapsuleRadius());
+		GetRootComponent()->TransformUpdated.AddUObject(this, &ATDCCharacter::OnRootTransformUpdated);
+	}
+}
+
+void ATDCCharacter::UnregisterSelectable()
+{
+	if (SelectionHandle != INDEX_NONE)
+	{
+		GetRootComponent()->TransformUpdated.RemoveAll(this);
+
+		FTDCSelectionIndex* SelectionIndex = TTDCWorldRegistry<FTDCSelectionIndex>::Find(GetWorld());
+		if (SelectionIndex)
+		{
+			SelectionIndex->Remove(SelectionHandle);
+		}
+		SelectionHandle = INDEX_NONE;
+	}
+}
+
+void ATDCCharacter::RegisterSignificance()
+{
+	if (SignificanceHandle == INDEX_NONE)
+	{
+		SignificanceHandle = FTDCSignificanceManager::Get(GetWorld()).Register(this, GetCapsuleComponent()->GetScaledCapsuleRadius(), true);
+	}
+}
+
+void ATDCCharacter::UnregisterSignificance()
+{
+	if (SignificanceHandle != INDEX_NONE)
+	{
+		FTDCSignificanceManager* SignificanceManager = TTDCWorldRegistry<FTDCSignificanceManager>::Find(GetWorld());
+		if (SignificanceManager)
+		{
+			SignificanceManager->Unregister(SignificanceHandle);
+		}
+		SignificanceHandle = INDEX_NONE;
+	}
+}
+
+void ATDCCharacter::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	FTDCSelectionIndex::Get(GetWorld()).Update(SelectionHandle, UpdatedComponent->GetComponentLocation());
+}
+
+void ATDCCharacter::SetPooled(bool bPooled)
+{
+	UCharacterMovementComponent* const MoveComp = GetCharacterMovement();
+	UAnimInstance* const AnimInstance = GetMesh()->GetAnimInstance();
+
+	if (bPooled)
+	{
+		MoveComp->StopMovementImmediately();
+		MoveComp->DisableMovement();
+		if (AnimInstance)
+		{
+			AnimInstance->StopAllMontages(0.0f);
+		}
+		UnregisterSelectable();
+		UnregisterSignificance();
+	}
+	else
+	{
+		MoveComp->SetDefaultMovementMode();
+		if (AnimInstance)
+		{
+			// back to the entry states, without creating a new anim instance
+			AnimInstance->InitializeAnimation();
+		}
+		RegisterSelectable();
+	}
+
+	SetActorHiddenInGame(bPooled);
+	SetActorEnableCollision(!bPooled);
+	MoveComp->SetComponentTickEnabled(!bPooled);
+	GetMesh()->SetComponentTickEnabled(!bPooled);
+
+	if (!bPooled)
+	{
+		RegisterSignificance();
+	}
+}
+
+void ATDCCharacter::Die()
+{
+	ATDCPlayerController* const OwningController = Cast<ATDCPlayerController>(GetOwner());
+	if (OwningController && OwningController->GetMainCharacter() == this)
+	{
+		OwningController->DespawnMainCharacter();
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void ATDCCharacter::FellOutOfWorld(const UDamageType& DmgType)
+{
+	Die();
+}
+
+void ATDCCharacter::WakeUp()
+{
+	// without waiting for the next significance update
+	FTDCSignificanceManager* SignificanceManager = TTDCWorldRegistry<FTDCSignificanceManager>::Find(GetWorld());
+	if (SignificanceManager && SignificanceHandle != INDEX_NONE)
+	{
+		SignificanceManager->Wake(SignificanceHandle);
+	}
+}
+
 
 // Called to bind functionality to input
 void ATDCCharacter::SetupPlayerInputComponent(class UInputComponent* InputComponent)
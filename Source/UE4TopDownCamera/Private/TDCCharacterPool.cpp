@@ -0,0 +1,137 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCCharacterPool.h"
+#include "TDCStats.h"
+
+FTDCCharacterPool::FTDCCharacterPool(UWorld* InWorld)
+	: World(InWorld)
+	, NumSpawned(0)
+	, NumHits(0)
+	, NumMisses(0)
+{
+}
+
+FTDCCharacterPool::~FTDCCharacterPool()
+{
+	if (NumHits + NumMisses > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("TDC character pool: %d hits, %d misses, %d pairs spawned"), NumHits, NumMisses, NumSpawned);
+	}
+}
+
+bool FTDCCharacterPool::SpawnPair(const FTransform& SpawnTransform, AActor* Owner, ESpawnActorCollisionHandlingMethod CollisionHandling, FPair& OutPair)
+{
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = CollisionHandling;
+	SpawnInfo.Owner = Owner;
+	SpawnInfo.Instigator = NULL;
+	SpawnInfo.bDeferConstruction = false;
+
+	ATDCCharacter* const Character = World->SpawnActor<ATDCCharacter>(SpawnTransform.GetLocation(), SpawnTransform.Rotator(), SpawnInfo);
+	if (Character == NULL)
+	{
+		return false;
+	}
+
+	ATDCAIController* const Controller = World->SpawnActor<ATDCAIController>(SpawnTransform.GetLocation(), SpawnTransform.Rotator(), SpawnInfo);
+	if (Controller == NULL)
+	{
+		Character->Destroy();
+		return false;
+	}
+
+	// Attach the character to its AI Controller
+	Controller->SetPawn(Character);
+	Controller->Possess(Character);
+
+	OutPair.Character = Character;
+	OutPair.Controller = Controller;
+	NumSpawned++;
+	return true;
+}
+
+void FTDCCharacterPool::Prewarm(int32 Count)
+{
+	// parked pairs are hidden and without collision, they don't need a free spot
+	while (NumSpawned < Count)
+	{
+		FPair Pair;
+		if (!SpawnPair(FTransform::Identity, NULL, ESpawnActorCollisionHandlingMethod::AlwaysSpawn, Pair))
+		{
+			break;
+		}
+
+		Pair.Controller->SetPooled(true);
+		Pair.Character->SetPooled(true);
+		FreePairs.Add(Pair);
+	}
+
+	UpdateStats();
+}
+
+bool FTDCCharacterPool::Acquire(const FTransform& SpawnTransform, AActor* Owner, ATDCCharacter*& OutCharacter, ATDCAIController*& OutController)
+{
+	while (FreePairs.Num() > 0)
+	{
+		const FPair Pair = FreePairs.Pop(false);
+		ATDCCharacter* const Character = Pair.Character.Get();
+		ATDCAIController* const Controller = Pair.Controller.Get();
+		if (Character == NULL || Controller == NULL || Character->IsPendingKill() || Controller->IsPendingKill())
+		{
+			// destroyed while pooled
+			continue;
+		}
+
+		Character->SetOwner(Owner);
+		Controller->SetOwner(Owner);
+		Controller->SetControlRotation(SpawnTransform.Rotator());
+		Character->SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+		Controller->SetPooled(false);
+		Character->SetPooled(false);
+
+		OutCharacter = Character;
+		OutController = Controller;
+		NumHits++;
+		UpdateStats();
+		return true;
+	}
+
+	NumMisses++;
+
+	FPair Pair;
+	const bool bSpawned = SpawnPair(SpawnTransform, Owner, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding, Pair);
+	OutCharacter = Pair.Character.Get();
+	OutController = Pair.Controller.Get();
+	UpdateStats();
+	return bSpawned;
+}
+
+void FTDCCharacterPool::Release(ATDCCharacter* Character, ATDCAIController* Controller)
+{
+	if (Character == NULL || Controller == NULL)
+	{
+		return;
+	}
+
+	Controller->SetPooled(true);
+	Character->SetPooled(true);
+	Character->SetOwner(NULL);
+	Controller->SetOwner(NULL);
+
+	FPair Pair;
+	Pair.Character = Character;
+	Pair.Controller = Controller;
+	FreePairs.Add(Pair);
+	UpdateStats();
+}
+
+void FTDCCharacterPool::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_TDC_CharacterPoolHits, NumHits);
+	SET_DWORD_STAT(STAT_TDC_CharacterPoolMisses, NumMisses);
+	SET_DWORD_STAT(STAT_TDC_CharacterPoolFree, FreePairs.Num());
+	CSV_CUSTOM_STAT(TDC, CharacterPoolHits, NumHits, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TDC, CharacterPoolMisses, NumMisses, ECsvCustomStatOp::Set);
+}
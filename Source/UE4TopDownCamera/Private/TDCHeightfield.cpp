@@ -0,0 +1,476 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCHeightfield.h"
+#include "TDCStats.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Engine/LevelStreaming.h"
+
+/** 'TDCH' */
+#define TDC_HEIGHTFIELD_MAGIC 0x48434454
+#define TDC_HEIGHTFIELD_VERSION 1
+
+/** quantized sample of a hole */
+#define TDC_HEIGHTFIELD_HOLE 0xFFFF
+
+/** the most steps of a ray march, longer rays take longer steps */
+static const int32 MaxRaycastSteps = 4096;
+
+/** bisection steps refining where a ray meets the ground */
+static const int32 RaycastRefineSteps = 8;
+
+FTDCHeightfield::FTDCHeightfield()
+	: Offset(FVector::ZeroVector)
+	, Data(NULL)
+	, Header(NULL)
+	, Tiles(NULL)
+{
+}
+
+FTDCHeightfield::~FTDCHeightfield()
+{
+	// the region has to go before its file
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+TUniquePtr<FTDCHeightfield> FTDCHeightfield::Open(const FString& Filename)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*Filename))
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FTDCHeightfield> Heightfield(new FTDCHeightfield());
+
+	Heightfield->MappedFile.Reset(PlatformFile.OpenMapped(*Filename));
+	if (Heightfield->MappedFile.IsValid())
+	{
+		Heightfield->MappedRegion.Reset(Heightfield->MappedFile->MapRegion());
+	}
+
+	bool bValid;
+	if (Heightfield->MappedRegion.IsValid())
+	{
+		bValid = Heightfield->Init(Heightfield->MappedRegion->GetMappedPtr(), Heightfield->MappedRegion->GetMappedSize());
+	}
+	else
+	{
+		// no memory mapping on this platform
+		bValid = FFileHelper::LoadFileToArray(Heightfield->LoadedData, *Filename) &&
+			Heightfield->Init(Heightfield->LoadedData.GetData(), Heightfield->LoadedData.Num());
+	}
+
+	if (!bValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Heightfield %s is not valid, bake it again"), *Filename);
+		return nullptr;
+	}
+	return Heightfield;
+}
+
+bool FTDCHeightfield::Init(const uint8* InData, int64 InSize)
+{
+	if (InData == NULL || InSize < (int64)sizeof(FTDCHeightfieldHeader))
+	{
+		return false;
+	}
+
+	const FTDCHeightfieldHeader* InHeader = (const FTDCHeightfieldHeader*)InData;
+	if (InHeader->Magic != TDC_HEIGHTFIELD_MAGIC || InHeader->Version != TDC_HEIGHTFIELD_VERSION ||
+		InHeader->NumTilesX <= 0 || InHeader->NumTilesY <= 0 || InHeader->CellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	const int64 NumTiles = (int64)InHeader->NumTilesX * InHeader->NumTilesY;
+	const int64 TableEnd = sizeof(FTDCHeightfieldHeader) + NumTiles * sizeof(FTDCHeightfieldTile);
+	if (InSize < TableEnd)
+	{
+		return false;
+	}
+
+	const FTDCHeightfieldTile* InTiles = (const FTDCHeightfieldTile*)(InData + sizeof(FTDCHeightfieldHeader));
+	const int64 TileDataSize = TDC_HEIGHTFIELD_TILE_SIZE * TDC_HEIGHTFIELD_TILE_SIZE * sizeof(uint16);
+	for (int64 TileIndex = 0; TileIndex < NumTiles; TileIndex++)
+	{
+		const FTDCHeightfieldTile& Tile = InTiles[TileIndex];
+		if (Tile.Type > ETDCHeightfieldTile::Quantized ||
+			(Tile.Type == ETDCHeightfieldTile::Quantized && (int64)Tile.DataOffset + TileDataSize > InSize))
+		{
+			return false;
+		}
+	}
+
+	Data = InData;
+	Header = InHeader;
+	Tiles = InTiles;
+	return true;
+}
+
+bool FTDCHeightfield::GetSample(int32 X, int32 Y, float& OutHeight) const
+{
+	if (X < 0 || Y < 0 || X >= Header->NumTilesX * TDC_HEIGHTFIELD_TILE_SIZE || Y >= Header->NumTilesY * TDC_HEIGHTFIELD_TILE_SIZE)
+	{
+		return false;
+	}
+
+	const FTDCHeightfieldTile& Tile = Tiles[(Y / TDC_HEIGHTFIELD_TILE_SIZE) * Header->NumTilesX + X / TDC_HEIGHTFIELD_TILE_SIZE];
+	switch (Tile.Type)
+	{
+	case ETDCHeightfieldTile::Flat:
+		OutHeight = Tile.MinHeight;
+		return true;
+
+	case ETDCHeightfieldTile::Quantized:
+	{
+		const uint16* Samples = (const uint16*)(Data + Tile.DataOffset);
+		const uint16 Sample = Samples[(Y % TDC_HEIGHTFIELD_TILE_SIZE) * TDC_HEIGHTFIELD_TILE_SIZE + X % TDC_HEIGHTFIELD_TILE_SIZE];
+		if (Sample == TDC_HEIGHTFIELD_HOLE)
+		{
+			return false;
+		}
+		OutHeight = Tile.MinHeight + Sample * Tile.HeightScale;
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+bool FTDCHeightfield::GetHeight(const FVector2D& Location, float& OutHeight) const
+{
+	const float LocalX = (Location.X - Offset.X - Header->OriginX) / Header->CellSize;
+	const float LocalY = (Location.Y - Offset.Y - Header->OriginY) / Header->CellSize;
+	const int32 X = FMath::FloorToInt(LocalX);
+	const int32 Y = FMath::FloorToInt(LocalY);
+
+	float H00, H10, H01, H11;
+	if (!GetSample(X, Y, H00) || !GetSample(X + 1, Y, H10) || !GetSample(X, Y + 1, H01) || !GetSample(X + 1, Y + 1, H11))
+	{
+		return false;
+	}
+
+	const float AlphaX = LocalX - X;
+	const float AlphaY = LocalY - Y;
+	OutHeight = FMath::Lerp(FMath::Lerp(H00, H10, AlphaX), FMath::Lerp(H01, H11, AlphaX), AlphaY) + Offset.Z;
+	return true;
+}
+
+FBox2D FTDCHeightfield::GetBounds() const
+{
+	const FVector2D Min(Header->OriginX + Offset.X, Header->OriginY + Offset.Y);
+	return FBox2D(Min, Min + FVector2D(Header->NumTilesX, Header->NumTilesY) * GetTileExtent());
+}
+
+bool FTDCHeightfield::Write(const FString& Filename, const FVector2D& Origin, float CellSize, int32 NumTilesX, int32 NumTilesY, const FVector& LevelOffset, const TArray<float>& Heights)
+{
+	const int32 NumSamplesX = NumTilesX * TDC_HEIGHTFIELD_TILE_SIZE;
+	const int32 NumSamplesY = NumTilesY * TDC_HEIGHTFIELD_TILE_SIZE;
+	check(Heights.Num() == NumSamplesX * NumSamplesY);
+
+	FTDCHeightfieldHeader Header;
+	Header.Magic = TDC_HEIGHTFIELD_MAGIC;
+	Header.Version = TDC_HEIGHTFIELD_VERSION;
+	Header.OriginX = Origin.X;
+	Header.OriginY = Origin.Y;
+	Header.CellSize = CellSize;
+	Header.NumTilesX = NumTilesX;
+	Header.NumTilesY = NumTilesY;
+	Header.MinHeight = MAX_flt;
+	Header.MaxHeight = -MAX_flt;
+	Header.LevelOffsetX = LevelOffset.X;
+	Header.LevelOffsetY = LevelOffset.Y;
+	Header.LevelOffsetZ = LevelOffset.Z;
+
+	TArray<FTDCHeightfieldTile> Tiles;
+	Tiles.SetNumZeroed(NumTilesX * NumTilesY);
+	TArray<uint16> Samples;
+	const uint32 DataStart = sizeof(FTDCHeightfieldHeader) + Tiles.Num() * sizeof(FTDCHeightfieldTile);
+
+	for (int32 TileY = 0; TileY < NumTilesY; TileY++)
+	{
+		for (int32 TileX = 0; TileX < NumTilesX; TileX++)
+		{
+			auto GetTileHeight = [&](int32 X, int32 Y)
+			{
+				return Heights[(TileY * TDC_HEIGHTFIELD_TILE_SIZE + Y) * NumSamplesX + TileX * TDC_HEIGHTFIELD_TILE_SIZE + X];
+			};
+
+			float TileMin = MAX_flt;
+			float TileMax = -MAX_flt;
+			bool bHasHoles = false;
+			for (int32 Y = 0; Y < TDC_HEIGHTFIELD_TILE_SIZE; Y++)
+			{
+				for (int32 X = 0; X < TDC_HEIGHTFIELD_TILE_SIZE; X++)
+				{
+					const float Height = GetTileHeight(X, Y);
+					if (Height == MAX_flt)
+					{
+						bHasHoles = true;
+					}
+					else
+					{
+						TileMin = FMath::Min(TileMin, Height);
+						TileMax = FMath::Max(TileMax, Height);
+					}
+				}
+			}
+
+			FTDCHeightfieldTile& Tile = Tiles[TileY * NumTilesX + TileX];
+			if (TileMin > TileMax)
+			{
+				Tile.Type = ETDCHeightfieldTile::Empty;
+				continue;
+			}
+
+			Header.MinHeight = FMath::Min(Header.MinHeight, TileMin);
+			Header.MaxHeight = FMath::Max(Header.MaxHeight, TileMax);
+			Tile.MinHeight = TileMin;
+
+			if (!bHasHoles && TileMax - TileMin < KINDA_SMALL_NUMBER)
+			{
+				Tile.Type = ETDCHeightfieldTile::Flat;
+				continue;
+			}
+
+			Tile.Type = ETDCHeightfieldTile::Quantized;
+			Tile.DataOffset = DataStart + Samples.Num() * sizeof(uint16);
+			Tile.HeightScale = (TileMax - TileMin) / (TDC_HEIGHTFIELD_HOLE - 1);
+
+			for (int32 Y = 0; Y < TDC_HEIGHTFIELD_TILE_SIZE; Y++)
+			{
+				for (int32 X = 0; X < TDC_HEIGHTFIELD_TILE_SIZE; X++)
+				{
+					const float Height = GetTileHeight(X, Y);
+					if (Height == MAX_flt)
+					{
+						Samples.Add(TDC_HEIGHTFIELD_HOLE);
+					}
+					else
+					{
+						const float Sample = Tile.HeightScale > 0.0f ? (Height - TileMin) / Tile.HeightScale : 0.0f;
+						Samples.Add((uint16)FMath::Clamp(FMath::RoundToInt(Sample), 0, TDC_HEIGHTFIELD_HOLE - 1));
+					}
+				}
+			}
+		}
+	}
+
+	if (Header.MinHeight > Header.MaxHeight)
+	{
+		Header.MinHeight = 0.0f;
+		Header.MaxHeight = 0.0f;
+	}
+
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Ar.IsValid())
+	{
+		return false;
+	}
+
+	Ar->Serialize(&Header, sizeof(Header));
+	Ar->Serialize(Tiles.GetData(), Tiles.Num() * sizeof(FTDCHeightfieldTile));
+	Ar->Serialize(Samples.GetData(), Samples.Num() * sizeof(uint16));
+	return Ar->Close();
+}
+
+FTDCHeightfieldSampler::FTDCHeightfieldSampler(UWorld* InWorld)
+	: World(InWorld)
+	, MinHeight(0.0f)
+	, MaxHeight(0.0f)
+	, MinCellSize(0.0f)
+	, IndexCellSize(1.0f)
+{
+	for (ULevel* Level : World->GetLevels())
+	{
+		AddLevel(Level);
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddRaw(this, &FTDCHeightfieldSampler::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddRaw(this, &FTDCHeightfieldSampler::OnLevelRemoved);
+}
+
+FTDCHeightfieldSampler::~FTDCHeightfieldSampler()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+}
+
+FString FTDCHeightfieldSampler::GetHeightfieldFilename(const FString& LevelPackageName)
+{
+	return FPaths::ProjectContentDir() / TEXT("Heightfields") / FPackageName::GetShortName(UWorld::RemovePIEPrefix(LevelPackageName)) + TEXT(".tdch");
+}
+
+void FTDCHeightfieldSampler::AddLevel(ULevel* Level)
+{
+	if (Level == NULL)
+	{
+		return;
+	}
+
+	TUniquePtr<FTDCHeightfield> Heightfield = FTDCHeightfield::Open(GetHeightfieldFilename(Level->GetOutermost()->GetName()));
+	if (!Heightfield.IsValid())
+	{
+		return;
+	}
+
+	// the level may be placed elsewhere than where it was baked
+	FVector LevelOffset = FVector::ZeroVector;
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		if (StreamingLevel && StreamingLevel->GetLoadedLevel() == Level)
+		{
+			LevelOffset = StreamingLevel->LevelTransform.GetLocation();
+			break;
+		}
+	}
+	Heightfield->Offset = LevelOffset - Heightfield->GetBakedLevelOffset();
+
+	Heightfields.Add(Level, MoveTemp(Heightfield));
+	UpdateIndex();
+}
+
+void FTDCHeightfieldSampler::OnLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld == World)
+	{
+		AddLevel(Level);
+	}
+}
+
+void FTDCHeightfieldSampler::OnLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld == World)
+	{
+		if (Level == NULL)
+		{
+			Heightfields.Reset();
+		}
+		else
+		{
+			Heightfields.Remove(Level);
+		}
+		UpdateIndex();
+	}
+}
+
+void FTDCHeightfieldSampler::UpdateIndex()
+{
+	MinHeight = MAX_flt;
+	MaxHeight = -MAX_flt;
+	MinCellSize = MAX_flt;
+	IndexCellSize = 1.0f;
+	for (const TPair<ULevel*, TUniquePtr<FTDCHeightfield>>& Pair : Heightfields)
+	{
+		MinHeight = FMath::Min(MinHeight, Pair.Value->GetMinHeight());
+		MaxHeight = FMath::Max(MaxHeight, Pair.Value->GetMaxHeight());
+		MinCellSize = FMath::Min(MinCellSize, Pair.Value->GetCellSize());
+		IndexCellSize = FMath::Max(IndexCellSize, Pair.Value->GetTileExtent());
+	}
+
+	// levels only stream in and out now and then, the index is rebuilt rather than patched
+	Cells.Reset();
+	for (const TPair<ULevel*, TUniquePtr<FTDCHeightfield>>& Pair : Heightfields)
+	{
+		const FBox2D Bounds = Pair.Value->GetBounds();
+		const FIntPoint MinCell = GetCell(Bounds.Min);
+		const FIntPoint MaxCell = GetCell(Bounds.Max);
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				Cells.FindOrAdd(FIntPoint(X, Y)).Add(Pair.Value.Get());
+			}
+		}
+	}
+}
+
+FIntPoint FTDCHeightfieldSampler::GetCell(const FVector2D& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / IndexCellSize), FMath::FloorToInt(Location.Y / IndexCellSize));
+}
+
+bool FTDCHeightfieldSampler::GetHeight(const FVector2D& Location, float& OutHeight) const
+{
+	const TArray<const FTDCHeightfield*, TInlineAllocator<1>>* Cell = Cells.Find(GetCell(Location));
+	if (Cell == NULL)
+	{
+		return false;
+	}
+
+	bool bFound = false;
+	for (const FTDCHeightfield* Heightfield : *Cell)
+	{
+		float Height;
+		if (Heightfield->GetHeight(Location, Height) && (!bFound || Height > OutHeight))
+		{
+			OutHeight = Height;
+			bFound = true;
+		}
+	}
+	return bFound;
+}
+
+bool FTDCHeightfieldSampler::Raycast(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutGroundPoint) const
+{
+	if (Heightfields.Num() == 0 || RayDirection.Z > -KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	TDC_INC_COUNTER(HeightfieldQueries);
+
+	// only the part of the ray between the highest and the lowest ground can meet it
+	const float StartTime = FMath::Max((RayOrigin.Z - MaxHeight) / -RayDirection.Z, 0.0f);
+	const float EndTime = (RayOrigin.Z - MinHeight) / -RayDirection.Z;
+	if (EndTime < StartTime)
+	{
+		return false;
+	}
+
+	// half a cell per step, horizontally or vertically
+	const float StepScale = FMath::Max(FVector2D(RayDirection).Size(), -RayDirection.Z);
+	const float StepTime = FMath::Max(0.5f * MinCellSize / StepScale, (EndTime - StartTime) / MaxRaycastSteps);
+
+	auto IsBelowGround = [this, &RayOrigin, &RayDirection](float Time)
+	{
+		const FVector Point = RayOrigin + RayDirection * Time;
+		float Height;
+		return GetHeight(FVector2D(Point), Height) && Point.Z <= Height;
+	};
+
+	float AboveTime = StartTime;
+	for (float Time = StartTime; Time <= EndTime + StepTime; Time += StepTime)
+	{
+		if (!IsBelowGround(Time))
+		{
+			AboveTime = Time;
+			continue;
+		}
+
+		// refine between the last step above the ground and this one
+		float BelowTime = Time;
+		for (int32 i = 0; i < RaycastRefineSteps; i++)
+		{
+			const float MidTime = 0.5f * (AboveTime + BelowTime);
+			if (IsBelowGround(MidTime))
+			{
+				BelowTime = MidTime;
+			}
+			else
+			{
+				AboveTime = MidTime;
+			}
+		}
+
+		OutGroundPoint = RayOrigin + RayDirection * BelowTime;
+		GetHeight(FVector2D(OutGroundPoint), OutGroundPoint.Z);
+		return true;
+	}
+
+	return false;
+}
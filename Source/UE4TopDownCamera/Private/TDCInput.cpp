@@ -2,45 +2,246 @@
 
 #include "UE4TopDownCamera.h"
 #include "TDCInput.h"
+#include "TDCStats.h"
 
 UTDCInput::UTDCInput(const FObjectInitializer& ObjectInitializer) 
 	: Super(ObjectInitializer)
+	, DirtyKeys(0)
+	, TwoPointsDownTime(0.0f)
+	, MaxPinchDistanceSq(0.0f)
+	, MultiPointsDownTime(0.0f)
+	, MultiPointsAnchor(FVector2D::ZeroVector)
+	, MultiPointsAnchorNumPoints(0)
+	, MaxMultiPoints(0)
+	, bMultiPointsMoved(false)
+	, OnePointIndex(0)
+	, bOnePointShared(false)
 	, PrevTouchState(0)
+	, TouchSamplesHead(0)
+	, TouchSamplesTail(0)
+	, SampledTouchState(0)
+	, bUseTouchSamples(false)
+	, LastDetectionTime(0.0)
+	, DeviceClockOffset(0.0)
+	, bHasDeviceClockOffset(false)
+	, bMultiPointsTouch(false)
 {
+	TwoPointsIndex[0] = 0;
+	TwoPointsIndex[1] = 1;
+	static_assert(EGameKey::MAX <= 32, "DirtyKeys has one bit per game key");
+	static_assert((TOUCH_SAMPLE_BUFFER_SIZE & (TOUCH_SAMPLE_BUFFER_SIZE - 1)) == 0, "TOUCH_SAMPLE_BUFFER_SIZE must be a power of two");
 }
 
-void UTDCInput::UpdateDetection(float DeltaTime)
+void UTDCInput::RegisterActionBinding1P(int32 BindingIndex)
 {
-	UpdateGameKeys(DeltaTime);
-	ProcessKeyStates(DeltaTime);
+	const FActionBinding1P& AB = ActionBindings1P[BindingIndex];
+	if (AB.Key < EGameKey::MAX && AB.KeyEvent < ARRAY_COUNT(FSimpleKeyState::Events))
+	{
+		Dispatch1P[AB.Key][AB.KeyEvent].Add(BindingIndex);
+	}
+}
+
+void UTDCInput::RegisterActionBinding2P(int32 BindingIndex)
+{
+	const FActionBinding2P& AB = ActionBindings2P[BindingIndex];
+	if (AB.Key < EGameKey::MAX && AB.KeyEvent < ARRAY_COUNT(FSimpleKeyState::Events))
+	{
+		Dispatch2P[AB.Key][AB.KeyEvent].Add(BindingIndex);
+	}
+}
+
+void UTDCInput::RegisterActionBindingNP(int32 BindingIndex)
+{
+	const FActionBindingNP& AB = ActionBindingsNP[BindingIndex];
+	if (AB.Key < EGameKey::MAX && AB.KeyEvent < ARRAY_COUNT(FSimpleKeyState::Events))
+	{
+		DispatchNP[AB.Key][AB.KeyEvent].Add(BindingIndex);
+	}
+}
+
+FSimpleKeyState& UTDCInput::AddKeyEvent(EGameKey::Type Key, EInputEvent Event)
+{
+	FSimpleKeyState& KeyState = KeyStates[Key];
+	KeyState.Events[Event]++;
+	DirtyKeys |= (1 << Key);
+	return KeyState;
+}
+
+void UTDCInput::UpdateDetection(float DeltaTime, double CurrentTime)
+{
+	TDC_SCOPE_CYCLE_COUNTER(UpdateDetection);
+
+	if (!bUseTouchSamples)
+	{
+		// no touch events yet, sample the player input once per frame
+		UpdateGameKeys(DeltaTime, GatherTouchStates());
+		ProcessKeyStates(DeltaTime, true);
+		LastDetectionTime = CurrentTime;
+		return;
+	}
+
+	// run the detection on every touch event received since the last frame, with their own timing
+	// presses and releases are dispatched as they happen, repeats are held for the last step of the frame
+	while (TouchSamplesTail != TouchSamplesHead)
+	{
+		const FTouchSample& Sample = TouchSamples[TouchSamplesTail];
+		TouchSamplesTail = (TouchSamplesTail + 1) & (TOUCH_SAMPLE_BUFFER_SIZE - 1);
+
+		ApplyTouchSample(Sample);
+
+		const float SampleDeltaTime = FMath::Max(Sample.Timestamp - LastDetectionTime, 0.0);
+		LastDetectionTime = FMath::Max(Sample.Timestamp, LastDetectionTime);
+
+		UpdateGameKeys(SampleDeltaTime, SampledTouchState);
+		ProcessKeyStates(SampleDeltaTime, false);
+	}
+
+	// time since the last event, for hold detection; the camera is updated once per frame, so are the swipes and pinches
+	const float RemainingDeltaTime = FMath::Max(CurrentTime - LastDetectionTime, 0.0);
+	LastDetectionTime = CurrentTime;
+
+	UpdateGameKeys(RemainingDeltaTime, SampledTouchState);
+	ProcessKeyStates(RemainingDeltaTime, true);
+}
+
+void UTDCInput::ApplyTouchSample(const FTouchSample& Sample)
+{
+	TouchPoints.Positions[Sample.Handle] = Sample.Position;
+	if (Sample.bDown)
+	{
+		SampledTouchState |= (1 << Sample.Handle);
+	}
+	else
+	{
+		SampledTouchState &= ~(1 << Sample.Handle);
+	}
+}
+
+double UTDCInput::GetTouchSampleTime(const FDateTime& DeviceTimestamp)
+{
+	// events delivered late are still this late when the device clock jumps, e.g. on a time zone change
+	const double MaxDeliveryDelay = 0.25;
+
+	const double Now = FPlatformTime::Seconds();
+	if (DeviceTimestamp.GetTicks() == 0)
+	{
+		return Now;
+	}
+
+	// the device clock is not FPlatformTime's; the quickest delivered event gives the offset between them
+	const double DeviceTime = (double)DeviceTimestamp.GetTicks() / ETimespan::TicksPerSecond;
+	const double Offset = Now - DeviceTime;
+	if (!bHasDeviceClockOffset || Offset < DeviceClockOffset || Offset - DeviceClockOffset > MaxDeliveryDelay)
+	{
+		DeviceClockOffset = Offset;
+		bHasDeviceClockOffset = true;
+	}
+
+	return DeviceTime + DeviceClockOffset;
 }
 
-void UTDCInput::ProcessKeyStates(float DeltaTime)
+void UTDCInput::AddTouchSample(uint32 Handle, ETouchType::Type Type, const FVector2D& TouchLocation, double Timestamp)
 {
-	for (const FActionBinding1P& AB : ActionBindings1P)
+	if (Handle >= EKeys::NUM_TOUCH_KEYS)
+	{
+		return;
+	}
+
+	if (!bUseTouchSamples)
 	{
-		const FSimpleKeyState* KeyState = KeyStateMap.Find(AB.Key);
+		// switch over from the player input, keeping the touches that are already down
+		bUseTouchSamples = true;
+		SampledTouchState = PrevTouchState;
+	}
+
+	const uint32 Mask = TOUCH_SAMPLE_BUFFER_SIZE - 1;
+	const uint32 NextHead = (TouchSamplesHead + 1) & Mask;
+	if (NextHead == TouchSamplesTail)
+	{
+		// full, drop the oldest move, the events after it carry newer positions; presses and releases are kept
+		uint32 DropIndex = TouchSamplesTail;
+		while (DropIndex != TouchSamplesHead && !TouchSamples[DropIndex].bMoved)
+		{
+			DropIndex = (DropIndex + 1) & Mask;
+		}
 
-		if (KeyState && KeyState->Events[AB.KeyEvent] > 0)
+		if (DropIndex == TouchSamplesHead)
 		{
-			AB.ActionDelegate.ExecuteIfBound(KeyState->Position, KeyState->DownTime);
+			// nothing but presses and releases, apply the oldest one without detecting gestures on it
+			ApplyTouchSample(TouchSamples[TouchSamplesTail]);
+			LastDetectionTime = FMath::Max(TouchSamples[TouchSamplesTail].Timestamp, LastDetectionTime);
 		}
+		else
+		{
+			for (; DropIndex != TouchSamplesTail; DropIndex = (DropIndex - 1) & Mask)
+			{
+				TouchSamples[DropIndex] = TouchSamples[(DropIndex - 1) & Mask];
+			}
+		}
+		TouchSamplesTail = (TouchSamplesTail + 1) & Mask;
 	}
 
-	for (const FActionBinding2P& AB : ActionBindings2P)
+	FTouchSample& Sample = TouchSamples[TouchSamplesHead];
+	Sample.Timestamp = Timestamp;
+	Sample.Position = TouchLocation;
+	Sample.Handle = Handle;
+	Sample.bDown = (Type != ETouchType::Ended);
+	Sample.bMoved = (Type == ETouchType::Moved || Type == ETouchType::Stationary);
+	TouchSamplesHead = NextHead;
+}
+
+void UTDCInput::ProcessKeyStates(float DeltaTime, bool bDispatchRepeats)
+{
+	// events are dispatched in the order they happen to a key
+	static const EInputEvent DispatchOrder[] = { IE_Pressed, IE_Repeat, IE_Released };
+
+	// keys whose repeat is held for a later step
+	uint32 HeldRepeatKeys = 0;
+
+	// only visit the keys that fired
+	uint32 PendingKeys = DirtyKeys;
+	while (PendingKeys)
 	{
-		const FSimpleKeyState* KeyState = KeyStateMap.Find(AB.Key);
+		const uint32 KeyIndex = FMath::CountTrailingZeros(PendingKeys);
+		PendingKeys &= PendingKeys - 1;
+
+		const FSimpleKeyState& KeyState = KeyStates[KeyIndex];
 
-		if (KeyState && KeyState->Events[AB.KeyEvent] > 0)
+		// a release flushes the held repeat before it
+		if (!bDispatchRepeats && KeyState.Events[IE_Repeat] > 0 && KeyState.Events[IE_Released] == 0)
 		{
-			AB.ActionDelegate.ExecuteIfBound(KeyState->Position, KeyState->Position2, KeyState->DownTime);
+			HeldRepeatKeys |= (1 << KeyIndex);
+		}
+
+		for (EInputEvent KeyEvent : DispatchOrder)
+		{
+			if (KeyState.Events[KeyEvent] > 0 && !(KeyEvent == IE_Repeat && (HeldRepeatKeys & (1 << KeyIndex))))
+			{
+				for (int32 BindingIndex : Dispatch1P[KeyIndex][KeyEvent])
+				{
+					ActionBindings1P[BindingIndex].ActionDelegate.ExecuteIfBound(KeyState.Position, KeyState.DownTime);
+				}
+
+				for (int32 BindingIndex : Dispatch2P[KeyIndex][KeyEvent])
+				{
+					ActionBindings2P[BindingIndex].ActionDelegate.ExecuteIfBound(KeyState.Position, KeyState.Position2, KeyState.DownTime);
+				}
+
+				for (int32 BindingIndex : DispatchNP[KeyIndex][KeyEvent])
+				{
+					ActionBindingsNP[BindingIndex].ActionDelegate.ExecuteIfBound(KeyState.Position, KeyState.NumPoints, KeyState.DownTime);
+				}
+			}
 		}
 	}
 
 	// update states
-	for (TMap<EGameKey::Type,FSimpleKeyState>::TIterator It(KeyStateMap); It; ++It)
+	while (DirtyKeys)
 	{
-		FSimpleKeyState* const KeyState = &It.Value();
+		const uint32 KeyIndex = FMath::CountTrailingZeros(DirtyKeys);
+		DirtyKeys &= DirtyKeys - 1;
+
+		FSimpleKeyState* const KeyState = &KeyStates[KeyIndex];
 
 		if (KeyState->Events[IE_Pressed])
 		{
@@ -53,58 +254,130 @@ void UTDCInput::ProcessKeyStates(float DeltaTime)
 
 		FMemory::Memzero(KeyState->Events, sizeof(KeyState->Events));
 	}
+
+	// held repeats stay pending, with the position of the last step
+	for (uint32 Pending = HeldRepeatKeys; Pending; Pending &= Pending - 1)
+	{
+		const uint32 KeyIndex = FMath::CountTrailingZeros(Pending);
+		KeyStates[KeyIndex].Events[IE_Repeat] = 1;
+		DirtyKeys |= (1 << KeyIndex);
+	}
 }
 
-void UTDCInput::UpdateGameKeys(float DeltaTime)
+uint32 UTDCInput::GatherTouchStates()
 {
 	APlayerController* MyController = CastChecked<APlayerController>(GetOuter());
+	const FVector* Touches = MyController->PlayerInput->Touches;
 
-	// gather current states
+	// the touches down last frame, and the free slots from the lowest up until one stays free:
+	// platforms give a new touch the lowest free index, so the walk grows with the active touches only
 	uint32 CurrentTouchState = 0;
-	for (int32 i = 0; i < ARRAY_COUNT(MyController->PlayerInput->Touches); i++)
+	for (uint32 Pending = PrevTouchState; Pending; Pending &= Pending - 1)
 	{
-		if (MyController->PlayerInput->Touches[i].Z != 0)
+		const int32 i = FMath::CountTrailingZeros(Pending);
+		if (Touches[i].Z != 0)
 		{
 			CurrentTouchState |= (1 << i);
 		}
 	}
 
+	for (uint32 Free = ~PrevTouchState & ((1 << EKeys::NUM_TOUCH_KEYS) - 1); Free; Free &= Free - 1)
+	{
+		const int32 i = FMath::CountTrailingZeros(Free);
+		if (Touches[i].Z == 0)
+		{
+			break;
+		}
+		CurrentTouchState |= (1 << i);
+	}
+
+	// positions of the active and just released touches
+	for (uint32 Pending = CurrentTouchState | PrevTouchState; Pending; Pending &= Pending - 1)
+	{
+		const int32 i = FMath::CountTrailingZeros(Pending);
+		TouchPoints.Positions[i] = FVector2D(Touches[i]);
+	}
+
+	return CurrentTouchState;
+}
+
+void UTDCInput::UpdateGameKeys(float DeltaTime, uint32 CurrentTouchState)
+{
+	// anchor the new touches
+	for (uint32 Pending = CurrentTouchState & ~PrevTouchState; Pending; Pending &= Pending - 1)
+	{
+		const int32 i = FMath::CountTrailingZeros(Pending);
+		TouchPoints.Anchors[i] = TouchPoints.Positions[i];
+		TouchPoints.DownTimes[i] = 0.0f;
+	}
+
+	const int32 NumTouches = FMath::CountBits(CurrentTouchState);
+	const int32 PrevNumTouches = FMath::CountBits(PrevTouchState);
+
+	// a finger added or lifted ends the gestures in progress, the touches still down start over from where they are
+	if (NumTouches != PrevNumTouches)
+	{
+		for (uint32 Pending = CurrentTouchState & PrevTouchState; Pending; Pending &= Pending - 1)
+		{
+			const int32 i = FMath::CountTrailingZeros(Pending);
+			TouchPoints.Anchors[i] = TouchPoints.Positions[i];
+		}
+	}
+
+	// one point actions follow the first touch down, once it is released and its release detected they move to the lowest touch still down
+	if (CurrentTouchState && !((CurrentTouchState | PrevTouchState) & (1 << OnePointIndex)))
+	{
+		OnePointIndex = FMath::CountTrailingZeros(CurrentTouchState);
+	}
+
+	bMultiPointsTouch = NumTouches >= 2;
+
 	// detection
-	FVector2D LocalPosition1 = FVector2D(MyController->PlayerInput->Touches[0]);
-	FVector2D LocalPosition2 = FVector2D(MyController->PlayerInput->Touches[1]);
+	const uint32 OnePointMask = 1 << OnePointIndex;
+	DetectOnePointActions((CurrentTouchState & OnePointMask) != 0, (PrevTouchState & OnePointMask) != 0, DeltaTime,
+		TouchPoints.Positions[OnePointIndex], TouchPoints.Anchors[OnePointIndex], TouchPoints.DownTimes[OnePointIndex]);
+
+	if (NumTouches == 2)
+	{
+		TwoPointsIndex[0] = FMath::CountTrailingZeros(CurrentTouchState);
+		TwoPointsIndex[1] = FMath::CountTrailingZeros(CurrentTouchState & (CurrentTouchState - 1));
+	}
+	DetectTwoPointsActions(NumTouches == 2, PrevNumTouches == 2, DeltaTime, TwoPointsIndex[0], TwoPointsIndex[1]);
+
+	DetectMultiPointsActions(NumTouches >= 3, PrevNumTouches >= 3, DeltaTime, NumTouches >= 3 ? CurrentTouchState : PrevTouchState);
 
-	DetectOnePointActions(CurrentTouchState & 1, PrevTouchState & 1, DeltaTime, LocalPosition1, TouchAnchors[0], Touch0DownTime);
-	DetectTwoPointsActions((CurrentTouchState & 1) && (CurrentTouchState & 2), (PrevTouchState & 1) && (PrevTouchState & 2),
-		DeltaTime, LocalPosition1, LocalPosition2);
+	// accumulate down times of the active touches
+	for (uint32 Pending = CurrentTouchState; Pending; Pending &= Pending - 1)
+	{
+		TouchPoints.DownTimes[FMath::CountTrailingZeros(Pending)] += DeltaTime;
+	}
 
 	// save states
 	PrevTouchState = CurrentTouchState;
 }
 
-void UTDCInput::DetectOnePointActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition, FVector2D& AnchorPosition, float& DownTime)
+void UTDCInput::DetectOnePointActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition, const FVector2D& AnchorPosition, float DownTime)
 {
 	const float HoldTime = 0.3f;
 
-	if (bCurrentState && !bTwoPointsTouch)
+	if (bCurrentState && !bPrevState)
 	{
-		// just pressed? set anchor and zero time
-		if (!bPrevState)
-		{
-			DownTime = 0;
-			AnchorPosition = CurrentPosition;
-		}
+		bOnePointShared = false;
+	}
 
+	if (bCurrentState && !bMultiPointsTouch)
+	{
 		// swipe detection & upkeep
-		FSimpleKeyState& SwipeState = KeyStateMap.FindOrAdd(EGameKey::Swipe);
+		FSimpleKeyState& SwipeState = KeyStates[EGameKey::Swipe];
 		if (SwipeState.bDown)
 		{
-			SwipeState.Events[IE_Repeat]++;
+			AddKeyEvent(EGameKey::Swipe, IE_Repeat);
 			SwipeState.Position = CurrentPosition;
 			SwipeState.DownTime = DownTime;
 		}
 		else if ((AnchorPosition - CurrentPosition).SizeSquared() > 0)
 			{
-				SwipeState.Events[IE_Pressed]++;
+				AddKeyEvent(EGameKey::Swipe, IE_Pressed);
 				SwipeState.Position = AnchorPosition;
 				SwipeState.DownTime = DownTime;
 			}
@@ -113,43 +386,52 @@ void UTDCInput::DetectOnePointActions(bool bCurrentState, bool bPrevState, float
 		// hold detection
 		if (DownTime + DeltaTime > HoldTime && DownTime <= HoldTime && !SwipeState.bDown)
 		{
-			FSimpleKeyState& HoldState = KeyStateMap.FindOrAdd(EGameKey::Hold);
-			HoldState.Events[IE_Pressed]++;
+			FSimpleKeyState& HoldState = AddKeyEvent(EGameKey::Hold, IE_Pressed);
 			HoldState.Position = AnchorPosition;
 			HoldState.DownTime = DownTime;
 		}
+	}
+	else if (bCurrentState)
+	{
+		// more fingers came down, end the swipe here; it starts over from a new anchor once they are lifted
+		bOnePointShared = true;
 
-		DownTime += DeltaTime;
+		FSimpleKeyState& SwipeState = KeyStates[EGameKey::Swipe];
+		if (SwipeState.bDown)
+		{
+			AddKeyEvent(EGameKey::Swipe, IE_Released);
+			SwipeState.Position = CurrentPosition;
+			SwipeState.DownTime = DownTime;
+		}
 	}
 	else
 	{
-		// just released? 
+		// just released?
 		if (bPrevState)
 		{
-			// tap detection
-			if (DownTime < HoldTime)
+			// tap detection, not when lifting a finger of a two or more points gesture
+			if (DownTime < HoldTime && !bOnePointShared)
 			{
-				FSimpleKeyState& TapState = KeyStateMap.FindOrAdd(EGameKey::Tap);
-				TapState.Events[IE_Pressed]++;
+				FSimpleKeyState& TapState = AddKeyEvent(EGameKey::Tap, IE_Pressed);
 				TapState.Position = AnchorPosition;
 				TapState.DownTime = DownTime;
 			}
 			else
 			{
-				FSimpleKeyState& HoldState = KeyStateMap.FindOrAdd(EGameKey::Hold);
+				FSimpleKeyState& HoldState = KeyStates[EGameKey::Hold];
 				if (HoldState.bDown)
 				{
-					HoldState.Events[IE_Released]++;
+					AddKeyEvent(EGameKey::Hold, IE_Released);
 					HoldState.Position = AnchorPosition;
 					HoldState.DownTime = DownTime;
 				}
 			}
 
 			// swipe finish
-			FSimpleKeyState& SwipeState = KeyStateMap.FindOrAdd(EGameKey::Swipe);
+			FSimpleKeyState& SwipeState = KeyStates[EGameKey::Swipe];
 			if (SwipeState.bDown)
 			{
-				SwipeState.Events[IE_Released]++;
+				AddKeyEvent(EGameKey::Swipe, IE_Released);
 				SwipeState.Position = CurrentPosition;
 				SwipeState.DownTime = DownTime;
 			}
@@ -157,48 +439,50 @@ void UTDCInput::DetectOnePointActions(bool bCurrentState, bool bPrevState, float
 	}
 }
 
-void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition1, const FVector2D& CurrentPosition2)
+void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, int32 Index1, int32 Index2)
 {
 	const float MaxSwipeDistance = 150.0f;			// swipe only if initial distance is lower
 	const float PinchDistanceThreshold = 150.0f;		// don't break pinch if distance exceeded threshold
 	const float PinchMoveThreshold = 50.0f;			// break pinch if midpoint moved further from initial spot 
 
-	bTwoPointsTouch = bCurrentState;
+	const FVector2D& CurrentPosition1 = TouchPoints.Positions[Index1];
+	const FVector2D& CurrentPosition2 = TouchPoints.Positions[Index2];
+	FVector2D& Anchor1 = TouchPoints.Anchors[Index1];
+	FVector2D& Anchor2 = TouchPoints.Anchors[Index2];
+
 	if (bCurrentState)
 	{
 		// just pressed? set anchors, time and pinch/swipe distinction
 		if (!bPrevState)
 		{
-			TouchAnchors[0] = CurrentPosition1;
-			TouchAnchors[1] = CurrentPosition2;
+			Anchor1 = CurrentPosition1;
+			Anchor2 = CurrentPosition2;
 			TwoPointsDownTime = 0.0f;
 			MaxPinchDistanceSq = 0.0f;
 
 			const float DistanceSq = (CurrentPosition1 - CurrentPosition2).SizeSquared();
 			if (DistanceSq < FMath::Square(MaxSwipeDistance))
 			{
-				FSimpleKeyState& SwipeState = KeyStateMap.FindOrAdd(EGameKey::SwipeTwoPoints);
-				SwipeState.Events[IE_Pressed]++;
+				FSimpleKeyState& SwipeState = AddKeyEvent(EGameKey::SwipeTwoPoints, IE_Pressed);
 				SwipeState.Position = CurrentPosition1;
 				SwipeState.Position2 = CurrentPosition2;
 				SwipeState.DownTime = TwoPointsDownTime;
 			}
 
-			FSimpleKeyState& PinchState = KeyStateMap.FindOrAdd(EGameKey::Pinch);
-			PinchState.Events[IE_Pressed]++;
+			FSimpleKeyState& PinchState = AddKeyEvent(EGameKey::Pinch, IE_Pressed);
 			PinchState.Position = CurrentPosition1;
 			PinchState.Position2 = CurrentPosition2;
 			PinchState.DownTime = TwoPointsDownTime;
 		}
 
-		FVector2D AnchorMidPoint = (TouchAnchors[0] + TouchAnchors[1]) * 0.5f;
+		FVector2D AnchorMidPoint = (Anchor1 + Anchor2) * 0.5f;
 		FVector2D CurrentMidPoint = (CurrentPosition1 + CurrentPosition2) * 0.5f;
 		float MovementDistanceSq = (CurrentMidPoint - AnchorMidPoint).SizeSquared();
-		float PinchDistanceSq = FMath::Abs((CurrentPosition2 - CurrentPosition1).SizeSquared() - (TouchAnchors[1] - TouchAnchors[0]).SizeSquared());
+		float PinchDistanceSq = FMath::Abs((CurrentPosition2 - CurrentPosition1).SizeSquared() - (Anchor2 - Anchor1).SizeSquared());
 		MaxPinchDistanceSq = FMath::Max(PinchDistanceSq, MaxPinchDistanceSq);
 
 		// finish swipe if distance changed before midpoint moved away from anchors
-		FSimpleKeyState& SwipeState = KeyStateMap.FindOrAdd(EGameKey::SwipeTwoPoints);
+		FSimpleKeyState& SwipeState = KeyStates[EGameKey::SwipeTwoPoints];
 		if (SwipeState.bDown)
 		{
 			bool bFinishSwipe = false;
@@ -208,14 +492,14 @@ void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, floa
 				bFinishSwipe = true;
 			}
 
-			SwipeState.Events[bFinishSwipe ? IE_Released : IE_Repeat]++;
+			AddKeyEvent(EGameKey::SwipeTwoPoints, bFinishSwipe ? IE_Released : IE_Repeat);
 			SwipeState.Position = CurrentPosition1;
 			SwipeState.Position2 = CurrentPosition2;
 			SwipeState.DownTime = TwoPointsDownTime;
 		}
 
 		// finish pinch if midpoint moved away from anchors before any distance changed
-		FSimpleKeyState& PinchState = KeyStateMap.FindOrAdd(EGameKey::Pinch);
+		FSimpleKeyState& PinchState = KeyStates[EGameKey::Pinch];
 		if (PinchState.bDown)
 		{
 			bool bFinishPinch = false;
@@ -225,7 +509,7 @@ void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, floa
 				bFinishPinch = true;
 			}
 
-			PinchState.Events[bFinishPinch ? IE_Released : IE_Repeat]++;
+			AddKeyEvent(EGameKey::Pinch, bFinishPinch ? IE_Released : IE_Repeat);
 			PinchState.Position = CurrentPosition1;
 			PinchState.Position2 = CurrentPosition2;
 			PinchState.DownTime = TwoPointsDownTime;
@@ -239,20 +523,20 @@ void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, floa
 		if (bPrevState)
 		{
 			// swipe finish
-			FSimpleKeyState& SwipeState = KeyStateMap.FindOrAdd(EGameKey::SwipeTwoPoints);
+			FSimpleKeyState& SwipeState = KeyStates[EGameKey::SwipeTwoPoints];
 			if (SwipeState.bDown)
 			{
-				SwipeState.Events[IE_Released]++;
+				AddKeyEvent(EGameKey::SwipeTwoPoints, IE_Released);
 				SwipeState.Position = CurrentPosition1;
 				SwipeState.Position2 = CurrentPosition2;
 				SwipeState.DownTime = TwoPointsDownTime;
 			}
 
 			// pinch finish
-			FSimpleKeyState& PinchState = KeyStateMap.FindOrAdd(EGameKey::Pinch);
+			FSimpleKeyState& PinchState = KeyStates[EGameKey::Pinch];
 			if (PinchState.bDown)
 			{
-				PinchState.Events[IE_Released]++;
+				AddKeyEvent(EGameKey::Pinch, IE_Released);
 				PinchState.Position = CurrentPosition1;
 				PinchState.Position2 = CurrentPosition2;
 				PinchState.DownTime = TwoPointsDownTime;
@@ -261,9 +545,86 @@ void UTDCInput::DetectTwoPointsActions(bool bCurrentState, bool bPrevState, floa
 	}
 }
 
+void UTDCInput::DetectMultiPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, uint32 TouchState)
+{
+	const float TapTime = 0.3f;				// tap only if released sooner
+	const float TapMoveThreshold = 50.0f;	// tap only if the center moved less
+
+	// center of the touches
+	FVector2D CenterPosition = FVector2D::ZeroVector;
+	int32 NumPoints = 0;
+	for (uint32 Pending = TouchState; Pending; Pending &= Pending - 1)
+	{
+		CenterPosition += TouchPoints.Positions[FMath::CountTrailingZeros(Pending)];
+		NumPoints++;
+	}
+	if (NumPoints > 0)
+	{
+		CenterPosition /= NumPoints;
+	}
+
+	FSimpleKeyState& SwipeState = KeyStates[EGameKey::SwipeMultiPoints];
+	if (bCurrentState)
+	{
+		// just pressed? zero time
+		if (!bPrevState)
+		{
+			MultiPointsDownTime = 0.0f;
+			MaxMultiPoints = 0;
+			MultiPointsAnchorNumPoints = 0;
+			bMultiPointsMoved = false;
+			AddKeyEvent(EGameKey::SwipeMultiPoints, IE_Pressed);
+		}
+		else if (SwipeState.bDown)
+		{
+			AddKeyEvent(EGameKey::SwipeMultiPoints, IE_Repeat);
+		}
+
+		// the center jumps when a finger is added or lifted, measure the movement from there
+		if (NumPoints != MultiPointsAnchorNumPoints)
+		{
+			MultiPointsAnchor = CenterPosition;
+			MultiPointsAnchorNumPoints = NumPoints;
+		}
+		MaxMultiPoints = FMath::Max(MaxMultiPoints, NumPoints);
+		bMultiPointsMoved |= (CenterPosition - MultiPointsAnchor).SizeSquared() > FMath::Square(TapMoveThreshold);
+
+		SwipeState.Position = CenterPosition;
+		SwipeState.NumPoints = NumPoints;
+		SwipeState.DownTime = MultiPointsDownTime;
+
+		MultiPointsDownTime += DeltaTime;
+	}
+	else if (bPrevState)
+	{
+		// tap detection, with the most points the touch had
+		if (MultiPointsDownTime < TapTime && !bMultiPointsMoved)
+		{
+			FSimpleKeyState& TapState = AddKeyEvent(EGameKey::TapMultiPoints, IE_Pressed);
+			TapState.Position = MultiPointsAnchor;
+			TapState.NumPoints = MaxMultiPoints;
+			TapState.DownTime = MultiPointsDownTime;
+		}
+
+		// swipe finish
+		if (SwipeState.bDown)
+		{
+			AddKeyEvent(EGameKey::SwipeMultiPoints, IE_Released);
+			SwipeState.Position = CenterPosition;
+			SwipeState.NumPoints = NumPoints;
+			SwipeState.DownTime = MultiPointsDownTime;
+		}
+	}
+}
 
 FVector2D UTDCInput::GetTouchAnchor(int32 i) const
 {
-	return (i >= 0 && i < ARRAY_COUNT(TouchAnchors)) ? TouchAnchors[i] : FVector2D::ZeroVector;
+	for (uint32 Pending = PrevTouchState; Pending; Pending &= Pending - 1)
+	{
+		if (i-- == 0)
+		{
+			return TouchPoints.Anchors[FMath::CountTrailingZeros(Pending)];
+		}
+	}
+	return FVector2D::ZeroVector;
 }
-
@@ -0,0 +1,232 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCInputRecorder.h"
+
+/** 'TDCI' */
+static const uint32 InputRecordingMagic = 0x54444349;
+static const uint32 InputRecordingVersion = 2;
+
+/** frames between two flushes of the recording */
+static const int32 RecordFlushInterval = 60;
+
+FTDCInputFrame::FTDCInputFrame()
+	: DeltaTime(0.0f)
+	, InputTime(0.0)
+	, MousePosition(FVector2D::ZeroVector)
+	, bHasMousePosition(false)
+	, ViewportSize(FIntPoint::ZeroValue)
+{
+	for (int32 i = 0; i < EKeys::NUM_TOUCH_KEYS; i++)
+	{
+		Touches[i] = FVector::ZeroVector;
+	}
+}
+
+FTDCInputRecorder& FTDCInputRecorder::Get()
+{
+	static FTDCInputRecorder Recorder;
+	return Recorder;
+}
+
+FTDCInputRecorder::FTDCInputRecorder()
+	: RecordFrameIndex(0)
+	, ReplayFrameIndex(0)
+	, FrameInputSeconds(0.0)
+	, FrameCameraSeconds(0.0)
+{
+	// the recorder itself is destroyed with the statics, long after the engine
+	FCoreDelegates::OnPreExit.AddRaw(this, &FTDCInputRecorder::Finish);
+
+	FString Filename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-TDCReplay="), Filename))
+	{
+		Reader.Reset(IFileManager::Get().CreateFileReader(*Filename));
+
+		uint32 Magic = 0, Version = 0, NumTouches = 0;
+		if (Reader.IsValid())
+		{
+			*Reader << Magic << Version << NumTouches;
+		}
+
+		if (Magic != InputRecordingMagic || Version != InputRecordingVersion || NumTouches != EKeys::NUM_TOUCH_KEYS)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Cannot replay input recording %s"), *Filename);
+			Reader.Reset();
+		}
+		else if (FParse::Value(FCommandLine::Get(), TEXT("-TDCReplayOut="), Filename))
+		{
+			ResultsWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+			if (ResultsWriter.IsValid())
+			{
+				const ANSICHAR Header[] = "Frame,DeltaTime,LocationX,LocationY,LocationZ,Pitch,Yaw,Roll,InputUs,CameraUs\n";
+				ResultsWriter->Serialize((void*)Header, sizeof(Header) - 1);
+			}
+		}
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("-TDCRecord="), Filename))
+	{
+		Writer.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+		if (Writer.IsValid())
+		{
+			uint32 Magic = InputRecordingMagic, Version = InputRecordingVersion, NumTouches = EKeys::NUM_TOUCH_KEYS;
+			*Writer << Magic << Version << NumTouches;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("Cannot record input to %s"), *Filename);
+		}
+	}
+}
+
+FTDCInputRecorder::~FTDCInputRecorder()
+{
+	Finish();
+}
+
+void FTDCInputRecorder::SerializeFrame(FArchive& Ar, FTDCInputFrame& Frame, uint32 ChangeMask, double FrameStartTime)
+{
+	if (ChangeMask & ChangedDeltaTime)
+	{
+		Ar << Frame.DeltaTime;
+	}
+	if (ChangeMask & ChangedMouse)
+	{
+		Ar << Frame.bHasMousePosition << Frame.MousePosition;
+	}
+	if (ChangeMask & ChangedViewportSize)
+	{
+		Ar << Frame.ViewportSize;
+	}
+	if (ChangeMask & HasTouchEvents)
+	{
+		int32 NumTouchEvents = Frame.TouchEvents.Num();
+		Ar.SerializeIntPacked(*(uint32*)&NumTouchEvents);
+		if (Ar.IsLoading())
+		{
+			Frame.TouchEvents.SetNumUninitialized(NumTouchEvents);
+		}
+
+		for (FTDCTouchEvent& TouchEvent : Frame.TouchEvents)
+		{
+			// relative to the start of the frame, small enough for a float
+			float TimeOffset = TouchEvent.Timestamp - FrameStartTime;
+			Ar << TimeOffset << TouchEvent.Position << TouchEvent.Handle << TouchEvent.Type;
+			if (Ar.IsLoading())
+			{
+				TouchEvent.Timestamp = FrameStartTime + TimeOffset;
+			}
+		}
+	}
+	else
+	{
+		Frame.TouchEvents.Reset();
+	}
+	for (int32 i = 0; i < EKeys::NUM_TOUCH_KEYS; i++)
+	{
+		if (ChangeMask & (ChangedTouch0 << i))
+		{
+			Ar << Frame.Touches[i];
+		}
+	}
+}
+
+void FTDCInputRecorder::RecordTouchEvent(uint32 Handle, ETouchType::Type Type, const FVector2D& Position, double Timestamp)
+{
+	if (Writer.IsValid())
+	{
+		FTDCTouchEvent& TouchEvent = PendingTouchEvents[PendingTouchEvents.AddUninitialized()];
+		TouchEvent.Timestamp = Timestamp;
+		TouchEvent.Position = Position;
+		TouchEvent.Handle = Handle;
+		TouchEvent.Type = Type;
+	}
+}
+
+void FTDCInputRecorder::RecordFrame(const FTDCInputFrame& Frame)
+{
+	if (!Writer.IsValid())
+	{
+		return;
+	}
+
+	uint32 ChangeMask = 0;
+	if (Frame.DeltaTime != PrevFrame.DeltaTime)
+	{
+		ChangeMask |= ChangedDeltaTime;
+	}
+	if (Frame.bHasMousePosition != PrevFrame.bHasMousePosition || Frame.MousePosition != PrevFrame.MousePosition)
+	{
+		ChangeMask |= ChangedMouse;
+	}
+	if (Frame.ViewportSize != PrevFrame.ViewportSize)
+	{
+		ChangeMask |= ChangedViewportSize;
+	}
+	if (PendingTouchEvents.Num() > 0)
+	{
+		ChangeMask |= HasTouchEvents;
+	}
+	for (int32 i = 0; i < EKeys::NUM_TOUCH_KEYS; i++)
+	{
+		if (Frame.Touches[i] != PrevFrame.Touches[i])
+		{
+			ChangeMask |= ChangedTouch0 << i;
+		}
+	}
+
+	// idle frames with a fixed time step only cost the mask byte
+	Writer->SerializeIntPacked(ChangeMask);
+	PrevFrame = Frame;
+	Exchange(PrevFrame.TouchEvents, PendingTouchEvents);
+	SerializeFrame(*Writer, PrevFrame, ChangeMask, Frame.InputTime - Frame.DeltaTime);
+	PendingTouchEvents.Reset();
+
+	// what was recorded so far survives a crash or a kill
+	if (++RecordFrameIndex % RecordFlushInterval == 0)
+	{
+		Writer->Flush();
+	}
+}
+
+bool FTDCInputRecorder::ReadFrame()
+{
+	if (!Reader.IsValid() || Reader->AtEnd())
+	{
+		return false;
+	}
+
+	uint32 ChangeMask = 0;
+	Reader->SerializeIntPacked(ChangeMask);
+	SerializeFrame(*Reader, ReplayFrame, ChangeMask, ReplayFrame.InputTime);
+
+	// the detection runs on the recorded time steps
+	ReplayFrame.InputTime += ReplayFrame.DeltaTime;
+
+	ReplayFrameIndex++;
+	FrameInputSeconds = 0.0;
+	FrameCameraSeconds = 0.0;
+	return !Reader->IsError();
+}
+
+void FTDCInputRecorder::WriteReplayResult(const FVector& CameraLocation, const FRotator& CameraRotation)
+{
+	// nothing replayed yet
+	if (!ResultsWriter.IsValid() || ReplayFrameIndex == 0)
+	{
+		return;
+	}
+
+	const FString Line = FString::Printf(TEXT("%d,%f,%f,%f,%f,%f,%f,%f,%.3f,%.3f\n"), ReplayFrameIndex - 1, ReplayFrame.DeltaTime,
+		CameraLocation.X, CameraLocation.Y, CameraLocation.Z, CameraRotation.Pitch, CameraRotation.Yaw, CameraRotation.Roll,
+		FrameInputSeconds * 1e6, FrameCameraSeconds * 1e6);
+	const FTCHARToUTF8 LineUTF8(*Line);
+	ResultsWriter->Serialize((void*)LineUTF8.Get(), LineUTF8.Length());
+}
+
+void FTDCInputRecorder::Finish()
+{
+	Writer.Reset();
+	Reader.Reset();
+	ResultsWriter.Reset();
+}
@@ -0,0 +1,154 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCNoScrollZones.h"
+
+/** Smallest cell size in pixels. */
+static const float MinNoScrollCellSize = 32.0f;
+
+/** Largest number of cells on each axis. */
+static const int32 MaxNoScrollGridSize = 64;
+
+/** Handles keep the slot of the zone in the low bits and its serial number in the high bits, leaving the sign bit clear. */
+static const int32 NoScrollSlotBits = 16;
+static const int32 NoScrollSlotMask = (1 << NoScrollSlotBits) - 1;
+static const int32 NoScrollSerialMask = (1 << (31 - NoScrollSlotBits)) - 1;
+
+FTDCNoScrollZones::FTDCNoScrollZones()
+	: NextSerial(1)
+	, GridOrigin(FVector2D::ZeroVector)
+	, GridSizeX(0)
+	, GridSizeY(0)
+	, CellSize(MinNoScrollCellSize)
+{
+}
+
+int32 FTDCNoScrollZones::Add(const FBox& InCoords)
+{
+	FZone Zone;
+	Zone.Coords = InCoords;
+	Zone.Serial = NextSerial;
+
+	// serial 0 is never used, so a zeroed handle is never valid
+	NextSerial = NextSerial < NoScrollSerialMask ? NextSerial + 1 : 1;
+
+	const int32 Slot = Zones.Add(Zone);
+	checkf(Slot <= NoScrollSlotMask, TEXT("Too many no scroll zones"));
+	RebuildGrid();
+	return (Zone.Serial << NoScrollSlotBits) | Slot;
+}
+
+FTDCNoScrollZones::FZone* FTDCNoScrollZones::FindZone(int32 Handle)
+{
+	const int32 Slot = Handle & NoScrollSlotMask;
+	if (Handle < 0 || !Zones.IsValidIndex(Slot) || Zones[Slot].Serial != (Handle >> NoScrollSlotBits))
+	{
+		return NULL;
+	}
+	return &Zones[Slot];
+}
+
+bool FTDCNoScrollZones::Update(int32 Handle, const FBox& InCoords)
+{
+	FZone* const Zone = FindZone(Handle);
+	if (Zone == NULL)
+	{
+		return false;
+	}
+
+	if (!(Zone->Coords == InCoords))
+	{
+		Zone->Coords = InCoords;
+		RebuildGrid();
+	}
+	return true;
+}
+
+bool FTDCNoScrollZones::Remove(int32 Handle)
+{
+	if (FindZone(Handle) == NULL)
+	{
+		return false;
+	}
+
+	Zones.RemoveAt(Handle & NoScrollSlotMask);
+	RebuildGrid();
+	return true;
+}
+
+void FTDCNoScrollZones::Empty()
+{
+	Zones.Empty();
+	RebuildGrid();
+}
+
+bool FTDCNoScrollZones::Contains(const FVector2D& Position) const
+{
+	const int32 CellX = FMath::FloorToInt((Position.X - GridOrigin.X) / CellSize);
+	const int32 CellY = FMath::FloorToInt((Position.Y - GridOrigin.Y) / CellSize);
+	if (CellX < 0 || CellY < 0 || CellX >= GridSizeX || CellY >= GridSizeY)
+	{
+		return false;
+	}
+
+	const FVector Coords(Position, 0.0f);
+	for (int32 Slot : Cells[CellY * GridSizeX + CellX])
+	{
+		if (Zones[Slot].Coords.IsInsideXY(Coords))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FTDCNoScrollZones::RebuildGrid()
+{
+	// keep the cell arrays around, zones are usually re-added with the same layout
+	for (TArray<int32, TInlineAllocator<4>>& Cell : Cells)
+	{
+		Cell.Reset();
+	}
+
+	FBox GridBounds(ForceInit);
+	for (const FZone& Zone : Zones)
+	{
+		GridBounds += Zone.Coords;
+	}
+
+	if (!GridBounds.IsValid)
+	{
+		GridSizeX = 0;
+		GridSizeY = 0;
+		return;
+	}
+
+	const FVector GridExtent = GridBounds.GetSize();
+	CellSize = FMath::Max3(MinNoScrollCellSize, GridExtent.X / MaxNoScrollGridSize, GridExtent.Y / MaxNoScrollGridSize);
+	GridOrigin = FVector2D(GridBounds.Min.X, GridBounds.Min.Y);
+	GridSizeX = FMath::Clamp(FMath::FloorToInt(GridExtent.X / CellSize) + 1, 1, MaxNoScrollGridSize + 1);
+	GridSizeY = FMath::Clamp(FMath::FloorToInt(GridExtent.Y / CellSize) + 1, 1, MaxNoScrollGridSize + 1);
+
+	const int32 NumCells = GridSizeX * GridSizeY;
+	if (Cells.Num() < NumCells)
+	{
+		Cells.SetNum(NumCells);
+	}
+
+	for (TSparseArray<FZone>::TConstIterator It(Zones); It; ++It)
+	{
+		const FBox& Zone = It->Coords;
+		const int32 MinX = FMath::Clamp(FMath::FloorToInt((Zone.Min.X - GridOrigin.X) / CellSize), 0, GridSizeX - 1);
+		const int32 MinY = FMath::Clamp(FMath::FloorToInt((Zone.Min.Y - GridOrigin.Y) / CellSize), 0, GridSizeY - 1);
+		const int32 MaxX = FMath::Clamp(FMath::FloorToInt((Zone.Max.X - GridOrigin.X) / CellSize), 0, GridSizeX - 1);
+		const int32 MaxY = FMath::Clamp(FMath::FloorToInt((Zone.Max.Y - GridOrigin.Y) / CellSize), 0, GridSizeY - 1);
+
+		for (int32 CellY = MinY; CellY <= MaxY; CellY++)
+		{
+			for (int32 CellX = MinX; CellX <= MaxX; CellX++)
+			{
+				Cells[CellY * GridSizeX + CellX].Add(It.GetIndex());
+			}
+		}
+	}
+}
@@ -2,16 +2,41 @@
 
 #include "UE4TopDownCamera.h"
 #include "TDCPlayerController.h"
-#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "TDCInputRecorder.h"
+#include "TDCAsyncPicker.h"
+#include "TDCSelectionIndex.h"
+#include "TDCSpawnRegistry.h"
+#include "TDCCharacterPool.h"
+#include "TDCSignificanceManager.h"
+#include "TDCHeightfield.h"
+#include "TDCStats.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+#include "NavFilters/NavigationQueryFilter.h"
+
+/** Pan speed of a two points swipe, each more point adds as much. */
+static const float MultiPointsSwipeSpeed = 10000.0f;
 
 ATDCPlayerController::ATDCPlayerController(const class FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
-	bEnableClickEvents = true;
+	// click and over events are dispatched from the picker cache, the engine would trace under the cursor every tick
+	bEnableClickEvents = false;
 	bEnableTouchEvents = true;
-	bEnableMouseOverEvents = true;
-	bEnableTouchEvents = true;
-	bEnableTouchOverEvents = true;
+	bEnableMouseOverEvents = false;
+	bEnableTouchOverEvents = false;
+	bDispatchClickEvents = true;
+	bDispatchOverEvents = true;
+	HoverTraceRate = 10.0f;
+	CursorCacheEpsilon = 2.0f;
+	HoverScreenPosition = FVector2D(-1.0f, -1.0f);
+	TimeSinceHoverTrace = 0.0f;
+	MaxHighSignificanceActors = 32;
+	TickThrottleRate = 5.0f;
+	TimeSinceTickThrottle = 0.0f;
+	bPredictStreaming = true;
+	StreamingLookAheadTime = 1.0f;
 
 	bShowMouseCursor = true;
 	CurrentMouseCursor = EMouseCursor::Crosshairs;
@@ -19,6 +44,13 @@ ATDCPlayerController::ATDCPlayerController(const class FObjectInitializer& Objec
 	bMoveToMouseCursor = false;
 	bCandidateMoveToMouseCursor = false;
 	MinDistanceToMoveCharacter = 20.0f;
+	MoveCoalesceRadius = 50.0f;
+	bUseAsyncPathfinding = true;
+	CharacterPoolSize = 1;
+	PendingPathQueryId = INVALID_NAVQUERYID;
+	MainCharacterMoveGoal = FVector::ZeroVector;
+	NumCoalescedMoveRequests = 0;
+	PrevSwipeNumPoints = 0;
 }
 
 void ATDCPlayerController::SetupInputComponent()
@@ -46,6 +78,8 @@ void ATDCPlayerController::SetupInputComponent()
 
 	// Camera controls
 	InputHandler = NewObject<UTDCInput>(this, UTDCInput::StaticClass(), TEXT("TDCInput"));
+	Picker = NewObject<UTDCAsyncPicker>(this, UTDCAsyncPicker::StaticClass(), TEXT("TDCAsyncPicker"));
+	Picker->ScreenEpsilon = CursorCacheEpsilon;
 
 	BIND_1P_ACTION(InputHandler, EGameKey::Tap, IE_Pressed, &ATDCPlayerController::OnTapPressed);
 	BIND_1P_ACTION(InputHandler, EGameKey::Hold, IE_Pressed, &ATDCPlayerController::OnHoldPressed);
@@ -57,56 +91,192 @@ void ATDCPlayerController::SetupInputComponent()
 	BIND_2P_ACTION(InputHandler, EGameKey::SwipeTwoPoints, IE_Repeat, &ATDCPlayerController::OnSwipeTwoPointsUpdate);
 	BIND_2P_ACTION(InputHandler, EGameKey::Pinch, IE_Pressed, &ATDCPlayerController::OnPinchStarted);
 	BIND_2P_ACTION(InputHandler, EGameKey::Pinch, IE_Repeat, &ATDCPlayerController::OnPinchUpdate);
+	BIND_NP_ACTION(InputHandler, EGameKey::SwipeMultiPoints, IE_Pressed, &ATDCPlayerController::OnSwipeMultiPointsStarted);
+	BIND_NP_ACTION(InputHandler, EGameKey::SwipeMultiPoints, IE_Repeat, &ATDCPlayerController::OnSwipeMultiPointsUpdate);
+	BIND_NP_ACTION(InputHandler, EGameKey::TapMultiPoints, IE_Pressed, &ATDCPlayerController::OnTapMultiPoints);
 }
 
 void ATDCPlayerController::BeginPlay()
 {
+	if (bPredictStreaming && IsLocalController())
+	{
+		StreamingPredictor = NewObject<UTDCStreamingPredictor>(this, UTDCStreamingPredictor::StaticClass(), TEXT("TDCStreamingPredictor"));
+		StreamingPredictor->LookAheadTime = StreamingLookAheadTime;
+	}
+
+	// the first controller of the map fills the pool, the others find it warm
+	FTDCCharacterPool::Get(GetWorld()).Prewarm(CharacterPoolSize);
+
+	// open the baked heightfields of the loaded levels before the first ground query
+	FTDCHeightfieldSampler::Get(GetWorld());
+
 	SpawnMainCharacter();
 
 	PlayerCameraManager->SetViewTarget(GetPawn());
 }
 
+void ATDCPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AbortMainCharacterPathQuery();
+
+	if (StreamingPredictor)
+	{
+		StreamingPredictor->Shutdown();
+	}
+
+	// a player leaving gives the character back, the pool goes away with the world otherwise
+	if (EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld)
+	{
+		DespawnMainCharacter();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
 
 void ATDCPlayerController::SpawnMainCharacter()
 {
-	APlayerStart* currentPlayStart = nullptr;
+	if (MainCharacter)
+	{
+		return;
+	}
+
+	UWorld* const World = GetWorld();
+
+	// the capsule decides how far apart spawn points are and how high above the ground it's spawned
+	float CapsuleRadius, CapsuleHalfHeight;
+	GetDefault<ATDCCharacter>()->GetCapsuleComponent()->GetScaledCapsuleSize(CapsuleRadius, CapsuleHalfHeight);
+
+	FTransform SpawnTransform;
+	if (!FTDCSpawnRegistry::Get(World).ClaimSpawnPoint(CapsuleRadius, CapsuleHalfHeight, SpawnTransform, MainCharacterSpawnPoint))
+	{
+		return;
+	}
 
-	for (TObjectIterator<APlayerStart> It; It; ++It)
+	// Spawn the main character, or take one from the pool
+	if (!FTDCCharacterPool::Get(World).Acquire(SpawnTransform, this, MainCharacter, MainCharacterController))
 	{
-		currentPlayStart = *It;
+		FTDCSpawnRegistry::Get(World).ReleaseSpawnPoint(MainCharacterSpawnPoint);
+		return;
+	}
 
-		FActorSpawnParameters SpawnInfo;
-		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
-		SpawnInfo.Owner = this;
-		SpawnInfo.Instigator = NULL;
-		SpawnInfo.bDeferConstruction = false;
-					
-		FVector spawnLocation(currentPlayStart->GetActorLocation());
-		spawnLocation.Z = 110; // 10 units above the floor level. Feel free to make this configurable
+	MainCharacter->OnEndPlay.AddDynamic(this, &ATDCPlayerController::OnMainCharacterEndPlay);
+}
 
-		// Spawn the main character!
-		MainCharacter = GetWorld()->SpawnActor<ATDCCharacter>(spawnLocation, 
-			currentPlayStart->GetActorRotation(), SpawnInfo);
+void ATDCPlayerController::DespawnMainCharacter()
+{
+	AbortMainCharacterPathQuery();
 
-		MainCharacterController = GetWorld()->SpawnActor<ATDCAIController>(spawnLocation,
-			currentPlayStart->GetActorRotation(), SpawnInfo);
+	UWorld* const World = GetWorld();
+	if (FTDCSpawnRegistry* SpawnRegistry = TTDCWorldRegistry<FTDCSpawnRegistry>::Find(World))
+	{
+		SpawnRegistry->ReleaseSpawnPoint(MainCharacterSpawnPoint);
+	}
 
-		// Attach the main character to its AI Controller
-		MainCharacterController->SetPawn(MainCharacter);
-		MainCharacterController->Possess(MainCharacter);
+	if (MainCharacter)
+	{
+		MainCharacter->OnEndPlay.RemoveDynamic(this, &ATDCPlayerController::OnMainCharacterEndPlay);
 
-		break; // don't create the character twice!
+		if (MainCharacter->IsActorBeingDestroyed() || !MainCharacter->HasActorBegunPlay())
+		{
+			// destroyed or removed by someone else, the controller has nothing left to possess
+			if (MainCharacterController && !MainCharacterController->IsActorBeingDestroyed() && !World->bIsTearingDown)
+			{
+				MainCharacterController->Destroy();
+			}
+		}
+		else
+		{
+			FTDCCharacterPool::Get(World).Release(MainCharacter, MainCharacterController);
+		}
 	}
+
+	MainCharacter = nullptr;
+	MainCharacterController = nullptr;
 }
 
 void ATDCPlayerController::ProcessPlayerInput(const float DeltaTime, const bool bGamePaused)
 {
+	TDC_SCOPE_CYCLE_COUNTER(ProcessPlayerInput);
+
+	float InputDeltaTime = DeltaTime;
+	double InputTime = FPlatformTime::Seconds();
+
+	FTDCInputRecorder& InputRecorder = FTDCInputRecorder::Get();
+	if (InputRecorder.IsReplaying() && PlayerInput)
+	{
+		// the camera of the previous frame has been updated by now
+		if (PlayerCameraManager)
+		{
+			InputRecorder.WriteReplayResult(PlayerCameraManager->GetCameraLocation(), PlayerCameraManager->GetCameraRotation());
+		}
+
+		if (InputRecorder.ReadFrame())
+		{
+			const FTDCInputFrame& Frame = InputRecorder.GetReplayFrame();
+			FMemory::Memcpy(PlayerInput->Touches, Frame.Touches, sizeof(Frame.Touches));
+			InputDeltaTime = Frame.DeltaTime;
+			InputTime = Frame.InputTime;
+
+			// the touch events of the frame with their recorded timing, as InputTouch queued them
+			if (InputHandler)
+			{
+				for (const FTDCTouchEvent& TouchEvent : Frame.TouchEvents)
+				{
+					InputHandler->AddTouchSample(TouchEvent.Handle, (ETouchType::Type)TouchEvent.Type, TouchEvent.Position, TouchEvent.Timestamp);
+				}
+			}
+		}
+		else
+		{
+			InputRecorder.Finish();
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+	else if (InputRecorder.IsRecording() && PlayerInput)
+	{
+		RecordInputFrame(DeltaTime, InputTime);
+	}
+
 	if (!bGamePaused && PlayerInput && InputHandler && !bIgnoreInput)
 	{
-		InputHandler->UpdateDetection(DeltaTime);
+		const double StartTime = FPlatformTime::Seconds();
+		InputHandler->UpdateDetection(InputDeltaTime, InputTime);
+		InputRecorder.AddInputTime(FPlatformTime::Seconds() - StartTime);
+	}
+
+	Super::ProcessPlayerInput(InputDeltaTime, bGamePaused);
+}
+
+void ATDCPlayerController::RecordInputFrame(float DeltaTime, double InputTime)
+{
+	FTDCInputFrame Frame;
+	Frame.DeltaTime = DeltaTime;
+	Frame.InputTime = InputTime;
+	FMemory::Memcpy(Frame.Touches, PlayerInput->Touches, sizeof(Frame.Touches));
+
+	ULocalPlayer* const LocalPlayer = Cast<ULocalPlayer>(Player);
+	if (LocalPlayer && LocalPlayer->ViewportClient && LocalPlayer->ViewportClient->Viewport)
+	{
+		Frame.bHasMousePosition = LocalPlayer->ViewportClient->GetMousePosition(Frame.MousePosition);
+		Frame.ViewportSize = LocalPlayer->ViewportClient->Viewport->GetSizeXY();
 	}
 
-	Super::ProcessPlayerInput(DeltaTime, bGamePaused);
+	FTDCInputRecorder::Get().RecordFrame(Frame);
+}
+
+bool ATDCPlayerController::InputTouch(uint32 Handle, ETouchType::Type Type, const FVector2D& TouchLocation, float Force, FDateTime DeviceTimestamp, uint32 TouchpadIndex)
+{
+	// keep every event for the gesture detection, not just the last state of the frame
+	// a replay drives the detection from the recorded touch events alone
+	FTDCInputRecorder& InputRecorder = FTDCInputRecorder::Get();
+	if (InputHandler && !bIgnoreInput && !InputRecorder.IsReplaying())
+	{
+		const double Timestamp = InputHandler->GetTouchSampleTime(DeviceTimestamp);
+		InputHandler->AddTouchSample(Handle, Type, TouchLocation, Timestamp);
+		InputRecorder.RecordTouchEvent(Handle, Type, TouchLocation, Timestamp);
+	}
+
+	return Super::InputTouch(Handle, Type, TouchLocation, Force, DeviceTimestamp, TouchpadIndex);
 }
 
 void ATDCPlayerController::UpdateRotation(float DeltaTime)
@@ -122,17 +292,112 @@ void ATDCPlayerController::UpdateRotation(float DeltaTime)
 	SetControlRotation(ViewRotation);
 }
 
-void ATDCPlayerController::MoveMainCharacterToLocation(FVector& location)
+bool ATDCPlayerController::MoveMainCharacterToLocation(const FVector& Destination, bool bAsync)
+{
+	if (MainCharacterController == NULL || MainCharacter == NULL)
+	{
+		return false;
+	}
+
+	// the path to the current goal already gets there
+	const bool bMovingToGoal = PendingPathQueryId != INVALID_NAVQUERYID || MainCharacterController->GetMoveStatus() == EPathFollowingStatus::Moving;
+	if (bMovingToGoal && FVector::DistSquared(Destination, MainCharacterMoveGoal) <= FMath::Square(MoveCoalesceRadius))
+	{
+		NumCoalescedMoveRequests++;
+		TDC_INC_COUNTER(CoalescedMoveRequests);
+		return false;
+	}
+
+	// a sleeping character would only start moving on the next significance update
+	MainCharacter->WakeUp();
+
+	MainCharacterMoveGoal = Destination;
+	if (bAsync && RequestMainCharacterPathAsync(Destination))
+	{
+		return true;
+	}
+
+	// a synchronous move replaces whatever was pending
+	AbortMainCharacterPathQuery();
+
+	TDC_INC_COUNTER(PathRequests);
+	MainCharacterController->MoveToLocation(Destination, -1.0f, true, true, true);
+	return true;
+}
+
+bool ATDCPlayerController::RequestMainCharacterPathAsync(const FVector& Destination)
+{
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* const NavData = NavSys ? NavSys->GetNavDataForProps(MainCharacter->GetNavAgentPropertiesRef()) : NULL;
+	if (NavData == NULL)
+	{
+		return false;
+	}
+
+	// a newer destination makes the query in flight stale
+	AbortMainCharacterPathQuery();
+
+	// same goal projection as MoveToLocation
+	FNavLocation ProjectedGoal;
+	const FVector GoalLocation = NavSys->ProjectPointToNavigation(Destination, ProjectedGoal, INVALID_NAVEXTENT, NavData) ? ProjectedGoal.Location : Destination;
+
+	FPathFindingQuery Query(MainCharacterController, *NavData, MainCharacter->GetNavAgentLocation(), GoalLocation,
+		UNavigationQueryFilter::GetQueryFilter(*NavData, MainCharacterController, MainCharacterController->GetDefaultNavigationFilterClass()));
+	Query.SetAllowPartialPaths(true);
+
+	TDC_INC_COUNTER(PathRequests);
+	PendingPathQueryId = NavSys->FindPathAsync(MainCharacter->GetNavAgentPropertiesRef(), Query,
+		FNavPathQueryDelegate::CreateUObject(this, &ATDCPlayerController::OnMainCharacterPathFound));
+
+	return PendingPathQueryId != INVALID_NAVQUERYID;
+}
+
+void ATDCPlayerController::OnMainCharacterPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	// superseded by a newer destination
+	if (QueryId != PendingPathQueryId)
+	{
+		return;
+	}
+
+	PendingPathQueryId = INVALID_NAVQUERYID;
+
+	if (Result == ENavigationQueryResult::Success && Path.IsValid() && MainCharacterController && MainCharacter)
+	{
+		FAIMoveRequest MoveRequest(MainCharacterMoveGoal);
+		MoveRequest.SetUsePathfinding(true);
+		MoveRequest.SetAllowPartialPath(true);
+		MoveRequest.SetCanStrafe(true);
+
+		MainCharacterController->RequestMove(MoveRequest, Path);
+	}
+}
+
+void ATDCPlayerController::AbortMainCharacterPathQuery()
+{
+	if (PendingPathQueryId != INVALID_NAVQUERYID)
+	{
+		UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+		if (NavSys)
+		{
+			NavSys->AbortAsyncFindPathRequest(PendingPathQueryId);
+		}
+		PendingPathQueryId = INVALID_NAVQUERYID;
+	}
+}
+
+void ATDCPlayerController::OnMainCharacterEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
 {
-	if (MainCharacterController)
+	if (Actor == MainCharacter)
 	{
-		//location.Z = 0;
-		MainCharacterController->MoveToLocation(location, -1.0f, true, true, true);
+		DespawnMainCharacter();
 	}
 }
 
 void ATDCPlayerController::PlayerTick(float DeltaTime)
 {
+	TDC_SCOPE_CYCLE_COUNTER(PlayerTick);
+
 	Super::PlayerTick(DeltaTime);
 
 	// keep updating the destination every tick while desired
@@ -151,18 +416,176 @@ void ATDCPlayerController::PlayerTick(float DeltaTime)
 		//set the Z to avoid flickering. The value doesn't matter, because the camera has its own configuration.
 		newLocation.Z = 800; 
 
+		TDC_INC_COUNTER(SetActorLocationCalls);
 		GetSpectatorPawn()->SetActorLocation(newLocation);
 	}
-	
+
+	if (bDispatchOverEvents)
+	{
+		UpdateHover(DeltaTime);
+	}
+
+	UpdateFromCameraView(DeltaTime);
+
+	// trace everything picked this frame, results come in at the start of the next one
+	if (Picker)
+	{
+		Picker->Flush();
+	}
+}
+
+void ATDCPlayerController::UpdateFromCameraView(float DeltaTime)
+{
+	UTDCCameraComponent* const CameraComponent = GetCameraComponent();
+	if (CameraComponent == NULL || PlayerCameraManager == NULL || !IsLocalController())
+	{
+		return;
+	}
+
+	// the view of the last camera update, read once for every actor
+	FVector2D Footprint[4];
+	if (CameraComponent->GetGroundFootprint(this, Footprint))
+	{
+		// significance only moves with the camera and the actors, no need to score every frame
+		TimeSinceTickThrottle += DeltaTime;
+		if (TickThrottleRate > 0.0f && TimeSinceTickThrottle >= 1.0f / TickThrottleRate)
+		{
+			TimeSinceTickThrottle = 0.0f;
+
+			FTDCSignificanceManager& SignificanceManager = FTDCSignificanceManager::Get(GetWorld());
+			SignificanceManager.MaxHighSignificance = MaxHighSignificanceActors;
+			SignificanceManager.Update(PlayerCameraManager->GetCameraLocation(),
+				FMath::Tan(FMath::DegreesToRadians(PlayerCameraManager->GetFOVAngle() * 0.5f)), GetFocalLocation(), Footprint);
+		}
+
+		if (StreamingPredictor)
+		{
+			StreamingPredictor->Update(DeltaTime, PlayerCameraManager->GetCameraLocation(), Footprint);
+		}
+	}
+}
+
+void ATDCPlayerController::UpdateHover(float DeltaTime)
+{
+	if (Picker == NULL)
+	{
+		return;
+	}
+
+	TimeSinceHoverTrace += DeltaTime;
+
+	// cached picks live as long as a hover trace, then actors may have moved under them
+	Picker->MaxCacheAge = HoverTraceRate > 0.0f ? 1.0f / HoverTraceRate : 0.0f;
+
+	float MouseX, MouseY;
+	if (GetMousePosition(MouseX, MouseY))
+	{
+		const FVector2D MousePosition(MouseX, MouseY);
+		if (!MousePosition.Equals(HoverScreenPosition, CursorCacheEpsilon))
+		{
+			// moved, the cache answers if something was picked there already
+			HoverScreenPosition = MousePosition;
+			Picker->RequestPick(MousePosition, CurrentClickTraceChannel, FTDCPickDelegate::CreateUObject(this, &ATDCPlayerController::OnHoverPicked));
+		}
+		else if (HoverTraceRate > 0.0f && TimeSinceHoverTrace >= 1.0f / HoverTraceRate)
+		{
+			// still, actors may move under the cursor
+			TimeSinceHoverTrace = 0.0f;
+			Picker->RequestPick(MousePosition, CurrentClickTraceChannel, FTDCPickDelegate::CreateUObject(this, &ATDCPlayerController::OnHoverPicked), false);
+		}
+	}
+
+	// touch over, from the cache while the fingers and the camera stay put
+	if (PlayerInput)
+	{
+		for (int32 TouchIndex = 0; TouchIndex < EKeys::NUM_TOUCH_KEYS; TouchIndex++)
+		{
+			const FVector& Touch = PlayerInput->Touches[TouchIndex];
+			if (Touch.Z != 0.0f)
+			{
+				Picker->RequestPick(FVector2D(Touch.X, Touch.Y), CurrentClickTraceChannel,
+					FTDCPickDelegate::CreateUObject(this, &ATDCPlayerController::OnTouchOverPicked, (ETouchIndex::Type)TouchIndex));
+			}
+			else if (CurrentTouchablePrimitives[TouchIndex].IsValid())
+			{
+				UPrimitiveComponent::DispatchTouchOverEvents((ETouchIndex::Type)TouchIndex, CurrentTouchablePrimitives[TouchIndex].Get(), NULL);
+				CurrentTouchablePrimitives[TouchIndex] = NULL;
+			}
+		}
+	}
+}
+
+void ATDCPlayerController::OnHoverPicked(bool bBlockingHit, const FHitResult& Hit)
+{
+	UPrimitiveComponent* const HoveredComponent = bBlockingHit ? Hit.Component.Get() : NULL;
+	UPrimitiveComponent::DispatchMouseOverEvents(CurrentClickablePrimitive.Get(), HoveredComponent);
+	CurrentClickablePrimitive = HoveredComponent;
+}
+
+void ATDCPlayerController::OnTouchOverPicked(bool bBlockingHit, const FHitResult& Hit, ETouchIndex::Type FingerIndex)
+{
+	UPrimitiveComponent* const TouchedComponent = bBlockingHit ? Hit.Component.Get() : NULL;
+	UPrimitiveComponent::DispatchTouchOverEvents(FingerIndex, CurrentTouchablePrimitives[FingerIndex].Get(), TouchedComponent);
+	CurrentTouchablePrimitives[FingerIndex] = TouchedComponent;
+}
+
+bool ATDCPlayerController::InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad)
+{
+	// clicks go to the hovered component instead of a trace of their own
+	if (bDispatchClickEvents && ClickEventKeys.Contains(Key))
+	{
+		if (EventType == IE_Pressed)
+		{
+			ClickedComponent = CurrentClickablePrimitive;
+			if (ClickedComponent.IsValid())
+			{
+				ClickedComponent->DispatchOnClicked(Key);
+			}
+		}
+		else if (EventType == IE_Released)
+		{
+			if (ClickedComponent.IsValid())
+			{
+				ClickedComponent->DispatchOnReleased(Key);
+			}
+			ClickedComponent = NULL;
+		}
+	}
+
+	return Super::InputKey(Key, EventType, AmountDepressed, bGamepad);
 }
 
 void ATDCPlayerController::MoveToMouseCursor()
 {
-	// Trace to see what is under the mouse cursor
-	FHitResult Hit;
-	GetHitResultUnderCursor(ECC_Visibility, false, Hit);
+	TDC_SCOPE_CYCLE_COUNTER(MoveToMouseCursor);
+
+	float MouseX, MouseY;
+	if (!GetMousePosition(MouseX, MouseY))
+	{
+		return;
+	}
+
+	// the ground under the cursor from the baked heightfields, this frame and without a trace
+	const FTDCHeightfieldSampler& Heightfields = FTDCHeightfieldSampler::Get(GetWorld());
+	FVector RayOrigin, RayDirection, GroundPoint;
+	if (Heightfields.HasData() &&
+		FTDCCameraHelpers::DeprojectScreenToWorld(FVector2D(MouseX, MouseY), Cast<ULocalPlayer>(Player), RayOrigin, RayDirection) &&
+		Heightfields.Raycast(RayOrigin, RayDirection, GroundPoint))
+	{
+		SetNewMoveDestination(GroundPoint);
+		return;
+	}
+
+	// Pick what is under the mouse cursor
+	if (Picker)
+	{
+		Picker->RequestPick(FVector2D(MouseX, MouseY), ECC_Visibility, FTDCPickDelegate::CreateUObject(this, &ATDCPlayerController::OnMouseCursorPicked));
+	}
+}
 
-	if (Hit.bBlockingHit)
+void ATDCPlayerController::OnMouseCursorPicked(bool bBlockingHit, const FHitResult& Hit)
+{
+	if (bBlockingHit)
 	{
 		// We hit something, move there
 		SetNewMoveDestination(Hit.ImpactPoint);
@@ -178,8 +601,7 @@ void ATDCPlayerController::SetNewMoveDestination(FVector DestLocation)
 		// We need to issue move command only if far enough in order for walk animation to play correctly
 		if (Distance > MinDistanceToMoveCharacter && GetCameraComponent())
 		{
-			UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, DestLocation);
-			MoveMainCharacterToLocation(DestLocation);
+			MoveMainCharacterToLocation(DestLocation, bUseAsyncPathfinding);
 		}
 	}
 }
@@ -240,20 +662,20 @@ void ATDCPlayerController::OnMouseScrollDown()
 
 void ATDCPlayerController::MoveForward(float Val)
 {
-	if (GetPawn() && MainCharacter)
+	if (Val != 0.f && GetPawn() && MainCharacter)
 	{
 		GetSpectatorPawn()->MoveForward(Val);
-		MainCharacterController->MoveToLocation(GetSpectatorPawn()->GetActorLocation());
+		MoveMainCharacterToLocation(GetSpectatorPawn()->GetActorLocation());
 	}
 }
 
 
 void ATDCPlayerController::MoveRight(float Val)
 {
-	if (GetPawn() && MainCharacter)
+	if (Val != 0.f && GetPawn() && MainCharacter)
 	{
 		GetSpectatorPawn()->MoveRight(Val);
-		MainCharacterController->MoveToLocation(GetSpectatorPawn()->GetActorLocation());
+		MoveMainCharacterToLocation(GetSpectatorPawn()->GetActorLocation());
 	}
 }
 
@@ -262,9 +684,8 @@ void ATDCPlayerController::MoveRight(float Val)
 
 void ATDCPlayerController::OnTapPressed(const FVector2D& ScreenPosition, float DownTime)
 {
-	FVector WorldPosition(0.f);
-	AActor* const HitActor = GetFriendlyTarget(ScreenPosition, WorldPosition);
-	if (MainCharacter && HitActor && HitActor == MainCharacter)
+	AActor* const HitActor = PickSelectableActor(ScreenPosition);
+	if (MainCharacter && HitActor && HitActor == MainCharacter && GetSpectatorPawn())
 	{
 		GetSpectatorPawn()->SetFollowMainCharacter(true);
 	}
@@ -303,20 +724,24 @@ void ATDCPlayerController::OnSwipeStarted(const FVector2D& AnchorPosition, float
 		GetCameraComponent()->OnSwipeStarted(AnchorPosition);
 	}
 
-	FVector WorldPosition(0.0f);
-	AActor* const HitActor = GetFriendlyTarget(AnchorPosition, WorldPosition);
+	// the camera pans until the pick says otherwise
+	SetSelectedActor(NULL, FVector::ZeroVector);
+	PickFriendlyTarget(AnchorPosition, FTDCPickDelegate::CreateUObject(this, &ATDCPlayerController::OnSwipeStartPicked));
 
-	SetSelectedActor(HitActor, WorldPosition);
+	PrevSwipeScreenPosition = AnchorPosition;
+
+	GetSpectatorPawn()->SetFollowMainCharacter(false);
+}
+
+void ATDCPlayerController::OnSwipeStartPicked(bool bBlockingHit, const FHitResult& Hit)
+{
+	SetSelectedActor(bBlockingHit ? Hit.GetActor() : NULL, Hit.ImpactPoint);
 
 	/** Get our position in 3d space */
 	if (SelectedActor.IsValid())
 	{
 		SwipeAnchor3D = SelectedActor->GetActorLocation();
 	}
-
-	PrevSwipeScreenPosition = AnchorPosition;
-
-	GetSpectatorPawn()->SetFollowMainCharacter(false);
 }
 
 void ATDCPlayerController::OnSwipeUpdate(const FVector2D& ScreenPosition, float DownTime)
@@ -376,11 +801,39 @@ void ATDCPlayerController::OnSwipeTwoPointsStarted(const FVector2D& ScreenPositi
 
 void ATDCPlayerController::OnSwipeTwoPointsUpdate(const FVector2D& ScreenPosition1, const FVector2D& ScreenPosition2, float DownTime)
 {
-	const FVector2D SwipeMidPoint = (ScreenPosition1 + ScreenPosition2) * 0.5f;
+	PanMultiPointsSwipe((ScreenPosition1 + ScreenPosition2) * 0.5f, 2);
+}
+
+void ATDCPlayerController::OnSwipeMultiPointsStarted(const FVector2D& CenterPosition, int32 NumPoints, float DownTime)
+{
+	PrevSwipeMidPoint = CenterPosition;
+	PrevSwipeNumPoints = NumPoints;
+}
+
+void ATDCPlayerController::OnSwipeMultiPointsUpdate(const FVector2D& CenterPosition, int32 NumPoints, float DownTime)
+{
+	// the center jumps when a finger is added or lifted, start over from there
+	if (NumPoints != PrevSwipeNumPoints)
+	{
+		OnSwipeMultiPointsStarted(CenterPosition, NumPoints, DownTime);
+		return;
+	}
+
+	// fast pan, every extra finger adds the speed of a two points swipe
+	PanMultiPointsSwipe(CenterPosition, NumPoints);
+	if (GetSpectatorPawn())
+	{
+		GetSpectatorPawn()->SetFollowMainCharacter(false);
+	}
+}
+
+void ATDCPlayerController::PanMultiPointsSwipe(const FVector2D& SwipeMidPoint, int32 NumPoints)
+{
 	const FVector MoveDir = FVector(SwipeMidPoint - PrevSwipeMidPoint, 0.0f).GetSafeNormal();
-	const float SwipeSpeed = 10000.0f;
+	const float SwipeSpeed = MultiPointsSwipeSpeed * (NumPoints - 1);
 
-	const FRotationMatrix R(PlayerCameraManager->GetCameraRotation() + FRotator(0.0, 90.0, 0.0));
+	// screen space is turned a quarter from the camera: screen X runs along the camera right
+	const FRotationMatrix R(PlayerCameraManager->GetCameraRotation() + FRotator(0.0f, 90.0f, 0.0f));
 	const FVector WorldSpaceAccel = R.TransformVector(MoveDir) * SwipeSpeed;
 	if (GetSpectatorPawn())
 	{
@@ -390,6 +843,15 @@ void ATDCPlayerController::OnSwipeTwoPointsUpdate(const FVector2D& ScreenPositio
 	PrevSwipeMidPoint = SwipeMidPoint;
 }
 
+void ATDCPlayerController::OnTapMultiPoints(const FVector2D& CenterPosition, int32 NumPoints, float DownTime)
+{
+	// quick zoom presets, the first one for three fingers
+	if (GetCameraComponent() != NULL)
+	{
+		GetCameraComponent()->SetQuickZoomLevel(NumPoints - 3);
+	}
+}
+
 void ATDCPlayerController::OnPinchStarted(const FVector2D& AnchorPosition1, const FVector2D& AnchorPosition2, float DownTime)
 {
 	// Pass the pinch through to the camera component.
@@ -435,16 +897,47 @@ void ATDCPlayerController::SetCameraTarget(const FVector& CameraTarget)
 	}
 }
 
-AActor* ATDCPlayerController::GetFriendlyTarget(const FVector2D& ScreenPoint, FVector& WorldPoint) const
+bool ATDCPlayerController::DeprojectSelectionPoints()
+{
+	return FTDCCameraHelpers::DeprojectScreenToWorldBatch(SelectionScreenPoints, Cast<ULocalPlayer>(Player), SelectionRayOrigins, SelectionRayDirections);
+}
+
+AActor* ATDCPlayerController::PickSelectableActor(const FVector2D& ScreenPosition)
+{
+	SelectionScreenPoints.Reset();
+	SelectionScreenPoints.Add(ScreenPosition);
+	if (!DeprojectSelectionPoints())
+	{
+		return NULL;
+	}
+
+	return FTDCSelectionIndex::Get(GetWorld()).FindAlongRay(SelectionRayOrigins[0], SelectionRayDirections[0]);
+}
+
+void ATDCPlayerController::SelectActorsInScreenRect(const FVector2D& FirstCorner, const FVector2D& SecondCorner, TArray<AActor*>& OutActors)
 {
-	FHitResult Hit;
-	if (GetHitResultAtScreenPosition(ScreenPoint, COLLISION_WEAPON, true, Hit))
+	OutActors.Reset();
+
+	// corners in order around the rectangle, their rays cut a convex quad at every height
+	SelectionScreenPoints.Reset();
+	SelectionScreenPoints.Add(FirstCorner);
+	SelectionScreenPoints.Add(FVector2D(SecondCorner.X, FirstCorner.Y));
+	SelectionScreenPoints.Add(SecondCorner);
+	SelectionScreenPoints.Add(FVector2D(FirstCorner.X, SecondCorner.Y));
+	if (!DeprojectSelectionPoints())
 	{
-		WorldPoint = Hit.ImpactPoint;
-		return Hit.GetActor();
+		return;
 	}
 
-	return NULL;
+	FTDCSelectionIndex::Get(GetWorld()).FindInRays(SelectionRayOrigins.GetData(), SelectionRayDirections.GetData(), OutActors);
+}
+
+void ATDCPlayerController::PickFriendlyTarget(const FVector2D& ScreenPoint, const FTDCPickDelegate& OnPicked)
+{
+	if (Picker)
+	{
+		Picker->RequestPick(ScreenPoint, COLLISION_WEAPON, OnPicked);
+	}
 }
 
 void ATDCPlayerController::SetIgnoreInput(bool bIgnore)
@@ -457,5 +950,11 @@ void ATDCPlayerController::SetSelectedActor(AActor* NewSelectedActor, const FVec
 	if (SelectedActor != NewSelectedActor)
 	{
 		SelectedActor = NewSelectedActor;
+
+		// a selected character is about to be given orders
+		if (ATDCCharacter* const SelectedCharacter = Cast<ATDCCharacter>(NewSelectedActor))
+		{
+			SelectedCharacter->WakeUp();
+		}
 	}
 }
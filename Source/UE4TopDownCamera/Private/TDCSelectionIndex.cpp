@@ -0,0 +1,225 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCSelectionIndex.h"
+#include "TDCCameraHelpers.h"
+
+/** cell size, a few characters wide */
+static const float SelectionCellSize = 1000.0f;
+
+FTDCSelectionIndex::FTDCSelectionIndex(UWorld* InWorld)
+	: CellSize(SelectionCellSize)
+	, MaxRadius(0.0f)
+	, MinHeight(MAX_flt)
+	, MaxHeight(-MAX_flt)
+{
+}
+
+FIntPoint FTDCSelectionIndex::GetCell(const FVector2D& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void FTDCSelectionIndex::AddHeight(float Height)
+{
+	MinHeight = FMath::Min(MinHeight, Height);
+	MaxHeight = FMath::Max(MaxHeight, Height);
+}
+
+int32 FTDCSelectionIndex::Add(AActor* Actor, float Radius)
+{
+	FEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Location = FVector2D(Actor->GetActorLocation());
+	Entry.Height = Actor->GetActorLocation().Z;
+	Entry.Radius = Radius;
+	AddHeight(Entry.Height);
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 Handle = Entries.Add(Entry);
+	Cells.FindOrAdd(Entry.Cell).Add(Handle);
+	MaxRadius = FMath::Max(MaxRadius, Radius);
+	return Handle;
+}
+
+void FTDCSelectionIndex::Update(int32 Handle, const FVector& Location)
+{
+	if (!Entries.IsAllocated(Handle))
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Handle];
+	Entry.Location = FVector2D(Location);
+	if (Entry.Height != Location.Z)
+	{
+		Entry.Height = Location.Z;
+		AddHeight(Entry.Height);
+	}
+
+	const FIntPoint NewCell = GetCell(Entry.Location);
+	if (NewCell != Entry.Cell)
+	{
+		TArray<int32, TInlineAllocator<8>>& OldCellEntries = Cells.FindChecked(Entry.Cell);
+		OldCellEntries.RemoveSingleSwap(Handle, false);
+		if (OldCellEntries.Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+
+		Cells.FindOrAdd(NewCell).Add(Handle);
+		Entry.Cell = NewCell;
+	}
+}
+
+void FTDCSelectionIndex::Remove(int32 Handle)
+{
+	if (!Entries.IsAllocated(Handle))
+	{
+		return;
+	}
+
+	const FIntPoint Cell = Entries[Handle].Cell;
+	TArray<int32, TInlineAllocator<8>>& CellEntries = Cells.FindChecked(Cell);
+	CellEntries.RemoveSingleSwap(Handle, false);
+	if (CellEntries.Num() == 0)
+	{
+		Cells.Remove(Cell);
+	}
+
+	Entries.RemoveAt(Handle);
+}
+
+template<typename FunctionType>
+void FTDCSelectionIndex::VisitCells(const FIntPoint& MinCell, const FIntPoint& MaxCell, FunctionType Function) const
+{
+	const int64 NumCoveredCells = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1);
+
+	// an area covering more cells than are used walks the used ones
+	if (NumCoveredCells > Cells.Num())
+	{
+		for (const TPair<FIntPoint, TArray<int32, TInlineAllocator<8>>>& Cell : Cells)
+		{
+			if (Cell.Key.X >= MinCell.X && Cell.Key.X <= MaxCell.X && Cell.Key.Y >= MinCell.Y && Cell.Key.Y <= MaxCell.Y)
+			{
+				Function(Cell.Value);
+			}
+		}
+		return;
+	}
+
+	for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+		{
+			const TArray<int32, TInlineAllocator<8>>* CellEntries = Cells.Find(FIntPoint(CellX, CellY));
+			if (CellEntries != NULL)
+			{
+				Function(*CellEntries);
+			}
+		}
+	}
+}
+
+/*
+ * Ground location where a ray crosses a height, linear in the height: Base + Slope * Height.
+ *
+ * @returns	false if the ray does not point down
+ */
+static bool GetRayHeightLine(const FVector& RayOrigin, const FVector& RayDirection, FVector2D& OutBase, FVector2D& OutSlope)
+{
+	if (RayDirection.Z > -KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	OutSlope = FVector2D(RayDirection) / RayDirection.Z;
+	OutBase = FVector2D(RayOrigin) - OutSlope * RayOrigin.Z;
+	return true;
+}
+
+AActor* FTDCSelectionIndex::FindAlongRay(const FVector& RayOrigin, const FVector& RayDirection) const
+{
+	FVector2D Base, Slope;
+	if (Entries.Num() == 0 || !GetRayHeightLine(RayOrigin, RayDirection, Base, Slope))
+	{
+		return NULL;
+	}
+
+	// the ray crosses the entry heights between these ground points, look as far as the largest radius around them
+	FBox2D RayBounds(ForceInit);
+	RayBounds += Base + Slope * MinHeight;
+	RayBounds += Base + Slope * MaxHeight;
+	const FIntPoint MinCell = GetCell(RayBounds.Min - FVector2D(MaxRadius, MaxRadius));
+	const FIntPoint MaxCell = GetCell(RayBounds.Max + FVector2D(MaxRadius, MaxRadius));
+
+	AActor* ClosestActor = NULL;
+	float ClosestDistanceSq = MAX_flt;
+	VisitCells(MinCell, MaxCell, [&](const TArray<int32, TInlineAllocator<8>>& CellEntries)
+	{
+		for (int32 Handle : CellEntries)
+		{
+			const FEntry& Entry = Entries[Handle];
+			const float DistanceSq = FVector2D::DistSquared(Entry.Location, Base + Slope * Entry.Height);
+			if (DistanceSq <= FMath::Square(Entry.Radius) && DistanceSq < ClosestDistanceSq)
+			{
+				AActor* const Actor = Entry.Actor.Get();
+				if (Actor != NULL)
+				{
+					ClosestActor = Actor;
+					ClosestDistanceSq = DistanceSq;
+				}
+			}
+		}
+	});
+
+	return ClosestActor;
+}
+
+void FTDCSelectionIndex::FindInRays(const FVector RayOrigins[4], const FVector RayDirections[4], TArray<AActor*>& OutActors) const
+{
+	if (Entries.Num() == 0)
+	{
+		return;
+	}
+
+	FVector2D Bases[4], Slopes[4];
+	for (int32 i = 0; i < 4; i++)
+	{
+		if (!GetRayHeightLine(RayOrigins[i], RayDirections[i], Bases[i], Slopes[i]))
+		{
+			return;
+		}
+	}
+
+	// the quads at every height between the lowest and the highest entry are inside the hull of these two
+	FBox2D QuadBounds(ForceInit);
+	for (int32 i = 0; i < 4; i++)
+	{
+		QuadBounds += Bases[i] + Slopes[i] * MinHeight;
+		QuadBounds += Bases[i] + Slopes[i] * MaxHeight;
+	}
+
+	VisitCells(GetCell(QuadBounds.Min), GetCell(QuadBounds.Max), [&](const TArray<int32, TInlineAllocator<8>>& CellEntries)
+	{
+		for (int32 Handle : CellEntries)
+		{
+			const FEntry& Entry = Entries[Handle];
+
+			FVector2D Corners[4];
+			for (int32 i = 0; i < 4; i++)
+			{
+				Corners[i] = Bases[i] + Slopes[i] * Entry.Height;
+			}
+
+			if (FTDCCameraHelpers::IsInsideConvexQuad(Corners, FTDCCameraHelpers::GetQuadWinding(Corners), Entry.Location))
+			{
+				AActor* const Actor = Entry.Actor.Get();
+				if (Actor != NULL)
+				{
+					OutActors.Add(Actor);
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,184 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCSignificanceManager.h"
+#include "TDCStats.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+
+FTDCSignificanceManager::FTDCSignificanceManager(UWorld* InWorld)
+	: MaxHighSignificance(32)
+	, HighScreenSize(0.03f)
+	, LowScreenSize(0.01f)
+	, World(InWorld)
+	, NumSleeping(0)
+{
+	FMemory::Memzero(NumInBucket);
+}
+
+int32 FTDCSignificanceManager::Register(AActor* Actor, float Radius, bool bAllowSleep)
+{
+	FEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Radius = Radius;
+	Entry.TickThrottleHandle = FTDCTickThrottle::Get(World).Add(Actor);
+	Entry.Significance = ETDCSignificance::Num;
+	Entry.bAllowSleep = bAllowSleep;
+	Entry.bSleeping = false;
+	return Entries.Add(Entry);
+}
+
+void FTDCSignificanceManager::Unregister(int32 Handle)
+{
+	if (!Entries.IsAllocated(Handle))
+	{
+		return;
+	}
+
+	Wake(Handle);
+
+	// the throttle is gone already if the whole world is
+	if (FTDCTickThrottle* TickThrottle = TTDCWorldRegistry<FTDCTickThrottle>::Find(World))
+	{
+		TickThrottle->Remove(Entries[Handle].TickThrottleHandle);
+	}
+
+	Entries.RemoveAt(Handle);
+}
+
+void FTDCSignificanceManager::Wake(int32 Handle)
+{
+	if (!Entries.IsAllocated(Handle) || !Entries[Handle].bSleeping)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Handle];
+	if (AActor* const Actor = Entry.Actor.Get())
+	{
+		SetSleeping(Actor, false);
+	}
+	Entry.bSleeping = false;
+	NumSleeping--;
+}
+
+ETDCSignificance::Type FTDCSignificanceManager::GetSignificance(int32 Handle) const
+{
+	return Entries.IsAllocated(Handle) ? Entries[Handle].Significance : ETDCSignificance::Num;
+}
+
+void FTDCSignificanceManager::SetSignificance(FTDCTickThrottle& TickThrottle, FEntry& Entry, ETDCSignificance::Type Significance)
+{
+	// the tick settings are the ones of the band of the bucket
+	TickThrottle.SetBand(Entry.TickThrottleHandle, (ETDCTickBand::Type)Significance);
+	Entry.Significance = Significance;
+	NumInBucket[Significance]++;
+}
+
+void FTDCSignificanceManager::Update(const FVector& ViewLocation, float TanHalfFOV, const FVector& FocalPoint, const FVector2D Footprint[4])
+{
+	TDC_SCOPE_CYCLE_COUNTER(Significance);
+
+	FTDCTickThrottle& TickThrottle = FTDCTickThrottle::Get(World);
+	TickThrottle.SetView(FocalPoint, Footprint);
+	const float ScreenScale = 1.0f / FMath::Max(TanHalfFOV, KINDA_SMALL_NUMBER);
+
+	FMemory::Memzero(NumInBucket);
+	HighCandidates.Reset();
+
+	for (TSparseArray<FEntry>::TIterator It(Entries); It; ++It)
+	{
+		FEntry& Entry = *It;
+		AActor* const Actor = Entry.Actor.Get();
+		if (Actor == NULL)
+		{
+			continue;
+		}
+
+		// fraction of half the view width the actor covers
+		const FVector Location = Actor->GetActorLocation();
+		const float Distance = FMath::Max(FVector::Dist(Location, ViewLocation), 1.0f);
+		const float ScreenSize = Entry.Radius * ScreenScale / Distance;
+
+		// the band of the throttle, moved up by the size on screen
+		ETDCSignificance::Type Significance = (ETDCSignificance::Type)TickThrottle.GetBandAt(Location);
+		if (Significance == ETDCSignificance::High || (Significance == ETDCSignificance::Medium && ScreenSize >= HighScreenSize))
+		{
+			// decided once the budget is known
+			FCandidate Candidate;
+			Candidate.Handle = It.GetIndex();
+			Candidate.ScreenSize = ScreenSize;
+			Candidate.bNearFocalPoint = Significance == ETDCSignificance::High;
+			HighCandidates.Add(Candidate);
+			continue;
+		}
+
+		if (Significance == ETDCSignificance::Dormant && ScreenSize >= LowScreenSize)
+		{
+			Significance = ETDCSignificance::Low;
+		}
+
+		SetSignificance(TickThrottle, Entry, Significance);
+		UpdateSleep(Entry, Actor);
+	}
+
+	// the ones near the focal point, then the largest on screen get the budget
+	if (HighCandidates.Num() > MaxHighSignificance)
+	{
+		HighCandidates.Sort([](const FCandidate& A, const FCandidate& B)
+		{
+			return A.bNearFocalPoint != B.bNearFocalPoint ? A.bNearFocalPoint : A.ScreenSize > B.ScreenSize;
+		});
+	}
+
+	for (int32 i = 0; i < HighCandidates.Num(); i++)
+	{
+		FEntry& Entry = Entries[HighCandidates[i].Handle];
+		SetSignificance(TickThrottle, Entry, i < MaxHighSignificance ? ETDCSignificance::High : ETDCSignificance::Medium);
+		UpdateSleep(Entry, Entry.Actor.Get());
+	}
+
+	SET_DWORD_STAT(STAT_TDC_HighSignificanceActors, NumInBucket[ETDCSignificance::High]);
+	SET_DWORD_STAT(STAT_TDC_MediumSignificanceActors, NumInBucket[ETDCSignificance::Medium]);
+	SET_DWORD_STAT(STAT_TDC_LowSignificanceActors, NumInBucket[ETDCSignificance::Low]);
+	SET_DWORD_STAT(STAT_TDC_DormantActors, NumInBucket[ETDCSignificance::Dormant]);
+	SET_DWORD_STAT(STAT_TDC_SleepingActors, NumSleeping);
+	CSV_CUSTOM_STAT(TDC, HighSignificanceActors, NumInBucket[ETDCSignificance::High], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TDC, SleepingActors, NumSleeping, ECsvCustomStatOp::Set);
+}
+
+void FTDCSignificanceManager::UpdateSleep(FEntry& Entry, AActor* Actor)
+{
+	const bool bShouldSleep = Entry.bAllowSleep && Entry.Significance == ETDCSignificance::Dormant && !IsActive(Actor);
+	if (bShouldSleep != Entry.bSleeping)
+	{
+		SetSleeping(Actor, bShouldSleep);
+		Entry.bSleeping = bShouldSleep;
+		NumSleeping += bShouldSleep ? 1 : -1;
+	}
+}
+
+void FTDCSignificanceManager::SetSleeping(AActor* Actor, bool bSleeping)
+{
+	TInlineComponentArray<UActorComponent*> Components(Actor);
+	for (UActorComponent* Component : Components)
+	{
+		if (Component->IsA<USkeletalMeshComponent>() || Component->IsA<UMovementComponent>())
+		{
+			Component->SetComponentTickEnabled(!bSleeping);
+		}
+	}
+}
+
+bool FTDCSignificanceManager::IsActive(AActor* Actor)
+{
+	if (!Actor->GetVelocity().IsNearlyZero())
+	{
+		return true;
+	}
+
+	// a move was requested, the movement component has to tick to start it
+	APawn* const Pawn = Cast<APawn>(Actor);
+	AAIController* const AIController = Pawn ? Cast<AAIController>(Pawn->GetController()) : NULL;
+	return AIController && AIController->GetMoveStatus() != EPathFollowingStatus::Idle;
+}
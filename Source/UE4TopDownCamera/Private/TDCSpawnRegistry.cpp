@@ -0,0 +1,196 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCSpawnRegistry.h"
+#include "TDCStats.h"
+#include "NavigationSystem.h"
+
+/** space left between two capsules */
+static const float SpawnSlotMargin = 20.0f;
+
+/** how far above and below a slot the ground is looked for */
+static const float GroundTraceUp = 500.0f;
+static const float GroundTraceDown = 2000.0f;
+
+/** height above the ground the capsule is spawned at */
+static const float SpawnHeightAboveGround = 10.0f;
+
+FTDCSpawnRegistry::FTDCSpawnRegistry(UWorld* InWorld)
+	: World(InWorld)
+	, NextStartIndex(0)
+{
+	// only the starts of this world, once
+	for (ULevel* Level : World->GetLevels())
+	{
+		AddLevel(Level);
+	}
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddRaw(this, &FTDCSpawnRegistry::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddRaw(this, &FTDCSpawnRegistry::OnLevelRemoved);
+}
+
+FTDCSpawnRegistry::~FTDCSpawnRegistry()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+}
+
+void FTDCSpawnRegistry::AddLevel(ULevel* Level)
+{
+	if (Level == NULL)
+	{
+		return;
+	}
+
+	for (AActor* Actor : Level->Actors)
+	{
+		APlayerStart* const PlayerStart = Cast<APlayerStart>(Actor);
+		if (PlayerStart && !PlayerStart->IsPendingKill())
+		{
+			FStart& Start = Starts[Starts.AddDefaulted()];
+			Start.PlayerStart = PlayerStart;
+			Start.Location = PlayerStart->GetActorLocation();
+			Start.Rotation = PlayerStart->GetActorRotation();
+		}
+	}
+}
+
+void FTDCSpawnRegistry::OnLevelAdded(ULevel* Level, UWorld* InWorld)
+{
+	if (InWorld == World)
+	{
+		AddLevel(Level);
+	}
+}
+
+void FTDCSpawnRegistry::OnLevelRemoved(ULevel* Level, UWorld* InWorld)
+{
+	// keep the indices of the other starts stable for the handles, the starts of the level just stop being used
+	if (InWorld == World)
+	{
+		for (FStart& Start : Starts)
+		{
+			APlayerStart* const PlayerStart = Start.PlayerStart.Get();
+			if (PlayerStart == NULL || Level == NULL || PlayerStart->GetLevel() == Level)
+			{
+				Start.PlayerStart.Reset();
+			}
+		}
+	}
+}
+
+FVector2D FTDCSpawnRegistry::GetSlotOffset(int32 Ring, int32 SlotInRing, float Spacing)
+{
+	if (Ring == 0)
+	{
+		return FVector2D::ZeroVector;
+	}
+
+	const float Angle = 2.0f * PI * SlotInRing / (6 * Ring);
+	return FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * (Ring * Spacing);
+}
+
+bool FTDCSpawnRegistry::FindGroundHeight(const FVector& Location, float& OutGroundZ) const
+{
+	TDC_INC_COUNTER(PhysicsTraces);
+
+	// static and movable geometry only, the pawns standing on it are not the ground
+	FCollisionObjectQueryParams GroundObjectParams;
+	GroundObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+	GroundObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+
+	FHitResult Hit;
+	const FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TDCSpawnGround), false);
+	if (World->LineTraceSingleByObjectType(Hit, Location + FVector(0.0f, 0.0f, GroundTraceUp), Location - FVector(0.0f, 0.0f, GroundTraceDown), GroundObjectParams, TraceParams))
+	{
+		OutGroundZ = Hit.ImpactPoint.Z;
+		return true;
+	}
+
+	UNavigationSystemV1* const NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	FNavLocation NavLocation;
+	if (NavSys && NavSys->ProjectPointToNavigation(Location, NavLocation, FVector(0.0f, 0.0f, GroundTraceDown)))
+	{
+		OutGroundZ = NavLocation.Location.Z;
+		return true;
+	}
+
+	return false;
+}
+
+bool FTDCSpawnRegistry::ClaimSpawnPoint(float Radius, float HalfHeight, FTransform& OutTransform, FTDCSpawnPointHandle& OutHandle)
+{
+	const float Spacing = 2.0f * Radius + SpawnSlotMargin;
+	const FCollisionShape Capsule = FCollisionShape::MakeCapsule(Radius, HalfHeight);
+	const FCollisionQueryParams OverlapParams(SCENE_QUERY_STAT(TDCSpawnOccupancy), false);
+
+	for (int32 StartOffset = 0; StartOffset < Starts.Num(); StartOffset++)
+	{
+		const int32 StartIndex = (NextStartIndex + StartOffset) % Starts.Num();
+		FStart& Start = Starts[StartIndex];
+		if (!Start.PlayerStart.IsValid())
+		{
+			continue;
+		}
+
+		int32 SlotIndex = 0;
+		for (int32 Ring = 0; ; Ring++)
+		{
+			const int32 NumRingSlots = (Ring == 0) ? 1 : 6 * Ring;
+			if (Start.ClaimedSlots.Num() < SlotIndex + NumRingSlots)
+			{
+				Start.ClaimedSlots.Add(false, SlotIndex + NumRingSlots - Start.ClaimedSlots.Num());
+			}
+
+			bool bRingHasClaims = false;
+			for (int32 SlotInRing = 0; SlotInRing < NumRingSlots; SlotInRing++, SlotIndex++)
+			{
+				if (Start.ClaimedSlots[SlotIndex])
+				{
+					bRingHasClaims = true;
+					continue;
+				}
+
+				FVector Location = Start.Location + FVector(GetSlotOffset(Ring, SlotInRing, Spacing), 0.0f);
+
+				float GroundZ;
+				if (FindGroundHeight(Location, GroundZ))
+				{
+					Location.Z = GroundZ + HalfHeight + SpawnHeightAboveGround;
+				}
+
+				// walls, props and actors that were not spawned here
+				if (World->OverlapBlockingTestByChannel(Location, FQuat::Identity, ECC_Pawn, Capsule, OverlapParams))
+				{
+					continue;
+				}
+
+				Start.ClaimedSlots[SlotIndex] = true;
+				NextStartIndex = (StartIndex + 1) % Starts.Num();
+
+				OutTransform = FTransform(Start.Rotation, Location);
+				OutHandle.StartIndex = StartIndex;
+				OutHandle.SlotIndex = SlotIndex;
+				return true;
+			}
+
+			// nothing of ours on the ring and the rest blocked, the rings further out are behind walls
+			if (!bRingHasClaims)
+			{
+				break;
+			}
+		}
+	}
+
+	return false;
+}
+
+void FTDCSpawnRegistry::ReleaseSpawnPoint(FTDCSpawnPointHandle& Handle)
+{
+	if (Handle.IsValid() && Starts.IsValidIndex(Handle.StartIndex))
+	{
+		Starts[Handle.StartIndex].ClaimedSlots[Handle.SlotIndex] = false;
+	}
+
+	Handle = FTDCSpawnPointHandle();
+}
@@ -7,6 +7,7 @@
 
 
 #define DEFAULT_ARM_LENGTH 800
+#define DEFAULT_CAMERA_LAG_SPEED 4
 
 ATDCSpectatorPawn::ATDCSpectatorPawn(const FObjectInitializer& OI)
 	: Super(OI.SetDefaultSubobjectClass<USpectatorPawnMovement>(Super::MovementComponentName))
@@ -14,6 +15,7 @@ ATDCSpectatorPawn::ATDCSpectatorPawn(const FObjectInitializer& OI)
 	GetCollisionComponent()->SetCollisionProfileName(UCollisionProfile::NoCollision_ProfileName);
 	bAddDefaultMovementBindings = true;
 	bFollowMainCharacter = true;
+	bLightweightCameraRig = true;
 
 	CameraBoomComp = OI.CreateDefaultSubobject<USpringArmComponent>(this, TEXT("CameraBoom"));
 	CameraBoomComp->SocketOffset = FVector(0, 0, 0); // how far the arm will be from the TargetArmLength on each axis
@@ -21,7 +23,7 @@ ATDCSpectatorPawn::ATDCSpectatorPawn(const FObjectInitializer& OI)
 	CameraBoomComp->SetRelativeRotation(FRotator(-85, 0, 0)); // rotation of the camera itself on Y so as to look at the character
 	CameraBoomComp->TargetArmLength = DEFAULT_ARM_LENGTH; // distance behind the character that the camera is placed
 	CameraBoomComp->bEnableCameraLag = true; //enable lag for more realistic camera
-	CameraBoomComp->CameraLagSpeed = 4; // the lower the lagier, 10=default, 1=max lag, but 0=no lag
+	CameraBoomComp->CameraLagSpeed = DEFAULT_CAMERA_LAG_SPEED; // the lower the lagier, 10=default, 1=max lag, but 0=no lag
 	CameraBoomComp->bUsePawnControlRotation = false;
 	CameraBoomComp->bInheritYaw = false; // don't rotate the dungeon when the character rotates
 	CameraBoomComp->SetupAttachment(GetRootComponent());
@@ -32,6 +34,26 @@ ATDCSpectatorPawn::ATDCSpectatorPawn(const FObjectInitializer& OI)
 	CameraComponent->SetupAttachment(CameraBoomComp);
 }
 
+void ATDCSpectatorPawn::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	SetLightweightCameraRig(bLightweightCameraRig);
+}
+
+void ATDCSpectatorPawn::SetLightweightCameraRig(bool bLightweight)
+{
+	bLightweightCameraRig = bLightweight;
+
+	// the camera component overrides the view the boom computes, its sweep and lag are thrown away
+	CameraBoomComp->SetComponentTickEnabled(!bLightweight);
+	CameraBoomComp->bDoCollisionTest = !bLightweight;
+	CameraBoomComp->bEnableCameraLag = !bLightweight;
+
+	// the view smooths its follow with FollowLagSpeed instead of the boom lag, starting from where the camera is
+	CameraComponent->ResetFollow();
+}
+
 void ATDCSpectatorPawn::MoveForward(float Val)
 {
 	Super::MoveForward(Val);
@@ -3,6 +3,7 @@
 #include "UE4TopDownCamera.h"
 #include "TDCSpectatorPawn.h"
 #include "TDCSpectatorPawnMovement.h"
+#include "TDCStats.h"
 
 UTDCSpectatorPawnMovement::UTDCSpectatorPawnMovement(const class FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer), 
 	bInitialLocationSet(false)
@@ -15,6 +16,8 @@ UTDCSpectatorPawnMovement::UTDCSpectatorPawnMovement(const class FObjectInitiali
 
 void UTDCSpectatorPawnMovement::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
 {
+	TDC_SCOPE_CYCLE_COUNTER(SpectatorMovementTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
 	if (!PawnOwner || !UpdatedComponent)
@@ -28,6 +31,7 @@ void UTDCSpectatorPawnMovement::TickComponent(float DeltaTime, enum ELevelTick T
 		if (!bInitialLocationSet)
 		{
 			PawnOwner->SetActorRotation(PlayerController->GetControlRotation());
+			TDC_INC_COUNTER(SetActorLocationCalls);
 			PawnOwner->SetActorLocation(PlayerController->GetSpawnLocation());
 			bInitialLocationSet = true;
 		}
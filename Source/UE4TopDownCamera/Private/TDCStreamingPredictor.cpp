@@ -0,0 +1,224 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCStreamingPredictor.h"
+#include "TDCStats.h"
+#include "ContentStreaming.h"
+#include "NavigationSystem.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/TargetPoint.h"
+
+/** jumps faster than this, e.g. from the minimap, reset the velocity */
+static const float MaxTrackedSpeed = 50000.0f;
+
+/** navmesh tiles are removed this much further out than they are generated */
+static const float NavigationInvokerRemovalScale = 1.5f;
+
+UTDCStreamingPredictor::UTDCStreamingPredictor(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, LookAheadTime(1.0f)
+	, VelocitySmoothingTime(0.25f)
+	, MinPredictSpeed(500.0f)
+	, Velocity(FVector2D::ZeroVector)
+	, LastViewLocation(FVector::ZeroVector)
+	, bHasLastViewLocation(false)
+	, bPredicting(false)
+	, PredictedViewLocation(FVector::ZeroVector)
+	, PredictedBounds(ForceInit)
+	, bNavigationInvokerRegistered(false)
+	, NumPrefetchedLevels(0)
+	, NumPrefetchHits(0)
+	, NumWastedLoads(0)
+{
+}
+
+UWorld* UTDCStreamingPredictor::GetWorld() const
+{
+	return GetOuter() ? GetOuter()->GetWorld() : NULL;
+}
+
+void UTDCStreamingPredictor::Update(float DeltaTime, const FVector& ViewLocation, const FVector2D Footprint[4])
+{
+	if (DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	if (!EndDrawHandle.IsValid() && GEngine && GEngine->GameViewport)
+	{
+		EndDrawHandle = GEngine->GameViewport->OnEndDraw().AddUObject(this, &UTDCStreamingPredictor::OnEndDraw);
+	}
+
+	// exponential moving average of the ground velocity
+	if (bHasLastViewLocation)
+	{
+		const FVector2D FrameVelocity = FVector2D(ViewLocation - LastViewLocation) / DeltaTime;
+		if (FrameVelocity.SizeSquared() > FMath::Square(MaxTrackedSpeed))
+		{
+			Velocity = FVector2D::ZeroVector;
+		}
+		else
+		{
+			const float Alpha = 1.0f - FMath::Exp(-DeltaTime / FMath::Max(VelocitySmoothingTime, KINDA_SMALL_NUMBER));
+			Velocity += (FrameVelocity - Velocity) * Alpha;
+		}
+	}
+	LastViewLocation = ViewLocation;
+	bHasLastViewLocation = true;
+
+	const FBox2D ViewBounds(Footprint, 4);
+	bPredicting = Velocity.SizeSquared() >= FMath::Square(MinPredictSpeed);
+
+	if (bPredicting)
+	{
+		const FVector2D Offset = Velocity * LookAheadTime;
+		PredictedViewLocation = ViewLocation + FVector(Offset, 0.0f);
+		PredictedBounds = FBox2D(ViewBounds.Min + Offset, ViewBounds.Max + Offset);
+
+		// texture streaming treats it as one more view for this frame only, it is added again every frame while predicting
+		IStreamingManager::Get().AddViewSlaveLocation(PredictedViewLocation, 1.0f, false, 0.0f);
+
+		UpdateNavigationInvoker(PredictedBounds.GetCenter(), PredictedBounds.GetExtent().Size());
+	}
+	else
+	{
+		UpdateNavigationInvoker(FVector2D::ZeroVector, 0.0f);
+	}
+
+	UpdateMetrics(ViewBounds);
+}
+
+void UTDCStreamingPredictor::OnEndDraw()
+{
+	// level streaming volumes and world composition load around the view locations rendered last frame
+	UWorld* const World = GetWorld();
+	if (bPredicting && World)
+	{
+		World->ViewLocationsRenderedLastFrame.Add(PredictedViewLocation);
+	}
+}
+
+void UTDCStreamingPredictor::UpdateNavigationInvoker(const FVector2D& PredictedCenter, float Radius)
+{
+	UWorld* const World = GetWorld();
+	UNavigationSystemV1* const NavSys = World ? FNavigationSystem::GetCurrent<UNavigationSystemV1>(World) : NULL;
+	if (NavSys == NULL)
+	{
+		return;
+	}
+
+	AActor* Invoker = NavigationInvoker.Get();
+	if (Radius <= 0.0f)
+	{
+		if (Invoker && bNavigationInvokerRegistered)
+		{
+			NavSys->UnregisterNavigationInvoker(Invoker);
+		}
+		bNavigationInvokerRegistered = false;
+		return;
+	}
+
+	if (Invoker == NULL)
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnInfo.ObjectFlags |= RF_Transient;
+		Invoker = World->SpawnActor<ATargetPoint>(FVector(PredictedCenter, 0.0f), FRotator::ZeroRotator, SpawnInfo);
+		NavigationInvoker = Invoker;
+		if (Invoker == NULL)
+		{
+			return;
+		}
+	}
+
+	// keeps the height of the spawn, invokers only use the ground position
+	const FVector InvokerLocation(PredictedCenter, Invoker->GetActorLocation().Z);
+	Invoker->SetActorLocation(InvokerLocation);
+
+	// registering again only updates the radii
+	NavSys->RegisterNavigationInvoker(Invoker, Radius, Radius * NavigationInvokerRemovalScale);
+	bNavigationInvokerRegistered = true;
+}
+
+void UTDCStreamingPredictor::UpdateMetrics(const FBox2D& ViewBounds)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		ULevel* const LoadedLevel = StreamingLevel ? StreamingLevel->GetLoadedLevel() : NULL;
+		FTDCTrackedLevel* TrackedLevel = TrackedLevels.Find(StreamingLevel);
+
+		if (LoadedLevel == NULL)
+		{
+			if (TrackedLevel)
+			{
+				if (TrackedLevel->bPrefetched && !TrackedLevel->bSeen)
+				{
+					NumWastedLoads++;
+				}
+				TrackedLevels.Remove(StreamingLevel);
+			}
+			continue;
+		}
+
+		if (TrackedLevel == NULL)
+		{
+			// just loaded: for the current view, the predicted one, or something else
+			const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(LoadedLevel);
+
+			FTDCTrackedLevel NewLevel;
+			NewLevel.Bounds = FBox2D(FVector2D(LevelBounds.Min), FVector2D(LevelBounds.Max));
+			NewLevel.bSeen = NewLevel.Bounds.Intersect(ViewBounds);
+			NewLevel.bPrefetched = !NewLevel.bSeen && bPredicting && NewLevel.Bounds.Intersect(PredictedBounds);
+			if (NewLevel.bPrefetched)
+			{
+				NumPrefetchedLevels++;
+			}
+			TrackedLevels.Add(StreamingLevel, NewLevel);
+		}
+		else if (!TrackedLevel->bSeen && TrackedLevel->Bounds.Intersect(ViewBounds))
+		{
+			TrackedLevel->bSeen = true;
+			if (TrackedLevel->bPrefetched)
+			{
+				NumPrefetchHits++;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_TDC_PrefetchedLevels, NumPrefetchedLevels);
+	SET_DWORD_STAT(STAT_TDC_PrefetchHits, NumPrefetchHits);
+	SET_DWORD_STAT(STAT_TDC_WastedPrefetchLoads, NumWastedLoads);
+	CSV_CUSTOM_STAT(TDC, PrefetchHits, NumPrefetchHits, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TDC, WastedPrefetchLoads, NumWastedLoads, ECsvCustomStatOp::Set);
+}
+
+void UTDCStreamingPredictor::Shutdown()
+{
+	bPredicting = false;
+
+	if (EndDrawHandle.IsValid() && GEngine && GEngine->GameViewport)
+	{
+		GEngine->GameViewport->OnEndDraw().Remove(EndDrawHandle);
+	}
+	EndDrawHandle.Reset();
+
+	UpdateNavigationInvoker(FVector2D::ZeroVector, 0.0f);
+	if (AActor* Invoker = NavigationInvoker.Get())
+	{
+		Invoker->Destroy();
+	}
+	NavigationInvoker.Reset();
+
+	if (NumPrefetchedLevels > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("TDC streaming prefetch: %d levels prefetched, %.0f%% hit, %d wasted"),
+			NumPrefetchedLevels, GetPrefetchHitRate() * 100.0f, NumWastedLoads);
+	}
+}
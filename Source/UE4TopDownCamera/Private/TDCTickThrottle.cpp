@@ -0,0 +1,116 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#include "UE4TopDownCamera.h"
+#include "TDCTickThrottle.h"
+#include "TDCCameraHelpers.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+
+/** tick settings of a band */
+struct FTDCTickBand
+{
+	/** tick interval of movement and path following, 0 for every frame */
+	float MovementInterval;
+
+	/** tick interval of the skeletal meshes, 0 for every frame */
+	float AnimationInterval;
+
+	/** when the pose is updated */
+	EVisibilityBasedAnimTickOption::Type AnimTickOption;
+};
+
+/** per ETDCTickBand */
+static const FTDCTickBand TickBands[ETDCTickBand::Num] =
+{
+	{ 0.0f, 0.0f, EVisibilityBasedAnimTickOption::AlwaysTickPose },
+	{ 1.0f / 30.0f, 1.0f / 30.0f, EVisibilityBasedAnimTickOption::AlwaysTickPose },
+	{ 0.1f, 0.1f, EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered },
+	{ 0.25f, 0.25f, EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered },
+};
+
+FTDCTickThrottle::FTDCTickThrottle(UWorld* InWorld)
+	: NearDistance(2500.0f)
+	, FarDistance(10000.0f)
+	, ViewFocalPoint(FVector2D::ZeroVector)
+	, ViewWinding(0.0f)
+{
+	FMemory::Memzero(ViewFootprint);
+}
+
+int32 FTDCTickThrottle::Add(AActor* Actor)
+{
+	FEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Band = ETDCTickBand::Num;
+	return Entries.Add(Entry);
+}
+
+void FTDCTickThrottle::Remove(int32 Handle)
+{
+	if (Entries.IsAllocated(Handle))
+	{
+		Entries.RemoveAt(Handle);
+	}
+}
+
+void FTDCTickThrottle::SetView(const FVector& FocalPoint, const FVector2D Footprint[4])
+{
+	ViewFocalPoint = FVector2D(FocalPoint);
+	FMemory::Memcpy(ViewFootprint, Footprint, sizeof(ViewFootprint));
+	ViewWinding = FTDCCameraHelpers::GetQuadWinding(ViewFootprint);
+}
+
+ETDCTickBand::Type FTDCTickThrottle::GetBandAt(const FVector& Location) const
+{
+	const FVector2D Location2D(Location);
+	const float DistanceSq = FVector2D::DistSquared(Location2D, ViewFocalPoint);
+
+	if (FTDCCameraHelpers::IsInsideConvexQuad(ViewFootprint, ViewWinding, Location2D))
+	{
+		return DistanceSq <= FMath::Square(NearDistance) ? ETDCTickBand::NearInView : ETDCTickBand::FarInView;
+	}
+	return DistanceSq <= FMath::Square(FarDistance) ? ETDCTickBand::NearOutOfView : ETDCTickBand::FarOutOfView;
+}
+
+void FTDCTickThrottle::SetBand(int32 Handle, ETDCTickBand::Type Band)
+{
+	if (!Entries.IsAllocated(Handle))
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Handle];
+	AActor* const Actor = Entry.Actor.Get();
+	if (Actor && Band != Entry.Band)
+	{
+		ApplyBand(Actor, Band);
+		Entry.Band = Band;
+	}
+}
+
+void FTDCTickThrottle::ApplyBand(AActor* Actor, ETDCTickBand::Type Band)
+{
+	const FTDCTickBand& TickBand = TickBands[Band];
+
+	TInlineComponentArray<UActorComponent*> Components(Actor);
+	for (UActorComponent* Component : Components)
+	{
+		if (USkeletalMeshComponent* const Mesh = Cast<USkeletalMeshComponent>(Component))
+		{
+			Mesh->SetComponentTickInterval(TickBand.AnimationInterval);
+			Mesh->VisibilityBasedAnimTickOption = TickBand.AnimTickOption;
+		}
+		else if (Component->IsA<UMovementComponent>())
+		{
+			Component->SetComponentTickInterval(TickBand.MovementInterval);
+		}
+	}
+
+	// path following feeds the movement component, no need to run it more often
+	APawn* const Pawn = Cast<APawn>(Actor);
+	AAIController* const AIController = Pawn ? Cast<AAIController>(Pawn->GetController()) : NULL;
+	if (AIController && AIController->GetPathFollowingComponent())
+	{
+		AIController->GetPathFollowingComponent()->SetComponentTickInterval(TickBand.MovementInterval);
+	}
+}
@@ -14,7 +14,9 @@ class UE4TOPDOWNCAMERA_API ATDCAIController : public AAIController
 	GENERATED_UCLASS_BODY()
 
 public:
-	virtual void Possess(class APawn* inPawn) override;
 	virtual void UnPossess() override;
 
+	/** park the controller in the character pool with its pawn or bring it back, a pooled controller does not move */
+	void SetPooled(bool bPooled);
+
 };
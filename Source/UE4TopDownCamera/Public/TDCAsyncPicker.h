@@ -0,0 +1,143 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCAsyncPicker.generated.h"
+
+DECLARE_DELEGATE_TwoParams(FTDCPickDelegate, bool /*bBlockingHit*/, const FHitResult& /*Hit*/);
+
+/** pick requested this frame */
+struct FTDCPickRequest
+{
+	/** screen position to trace under */
+	FVector2D ScreenPosition;
+
+	/** channel to trace on */
+	TEnumAsByte<ECollisionChannel> Channel;
+
+	/** index of the deprojected screen position */
+	int32 RayIndex;
+
+	/** everyone who asked for this pick */
+	TArray<FTDCPickDelegate, TInlineAllocator<1>> Callbacks;
+};
+
+/** result of a past pick, valid from the camera it was traced from */
+struct FTDCCachedPick
+{
+	/** screen position that was picked */
+	FVector2D ScreenPosition;
+
+	/** channel that was traced */
+	TEnumAsByte<ECollisionChannel> Channel;
+
+	/** camera the pick was traced from */
+	FVector CameraLocation;
+	FRotator CameraRotation;
+
+	/** when the pick was traced, in FPlatformTime::Seconds */
+	double Time;
+
+	/** did the trace hit anything? */
+	bool bBlockingHit;
+
+	/** the hit */
+	FHitResult Hit;
+};
+
+/** pick answered from the cache, waiting to be delivered */
+struct FTDCReadyPick
+{
+	/** who asked for the pick */
+	FTDCPickDelegate Callback;
+
+	/** did the trace hit anything? */
+	bool bBlockingHit;
+
+	/** the hit */
+	FHitResult Hit;
+};
+
+/**
+ * Picks under screen positions with async line traces.
+ * Picks requested during a frame are deprojected together and traced when the frame is flushed; results are
+ * delivered at the start of the next frame.
+ * Results are cached per channel with the camera they were traced from; picks within ScreenEpsilon of a cached one,
+ * from a camera within CameraLocationEpsilon and CameraRotationEpsilon of its camera, are answered without a trace.
+ * Cached picks older than MaxCacheAge, or whose hit actor is gone, are traced again.
+ * They are delivered on the next flush, so callbacks never run from RequestPick and always a frame after the request.
+ */
+UCLASS()
+class UE4TOPDOWNCAMERA_API UTDCAsyncPicker : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+
+	/*
+	 * Queue a pick, picks of the same screen position and channel share a trace.
+	 *
+	 * @param	ScreenPosition	Screen coordinates to pick under.
+	 * @param	Channel			Channel to trace on.
+	 * @param	OnPicked		Called with the blocking hit, if any, next frame; never from within RequestPick.
+	 * @param	bAllowCached	If false, always trace and refresh the cache.
+	 */
+	void RequestPick(const FVector2D& ScreenPosition, ECollisionChannel Channel, const FTDCPickDelegate& OnPicked, bool bAllowCached = true);
+
+	/** distance in pixels under which a cached pick is reused */
+	float ScreenEpsilon;
+
+	/** camera movement under which a cached pick is reused, the camera settling or drifting does not miss the cache */
+	float CameraLocationEpsilon;
+	float CameraRotationEpsilon;
+
+	/** seconds a cached pick is reused for, actors move under it; 0 to never expire */
+	float MaxCacheAge;
+
+	/** deliver the cached picks of the last frame and issue the traces of the picks requested this frame, called once per frame by the owning controller */
+	void Flush();
+
+protected:
+
+	/** picks requested this frame */
+	TArray<FTDCPickRequest> PendingPicks;
+
+	/** picks traced last frame, waiting for their results */
+	TArray<FTDCPickRequest> InFlightPicks;
+
+	/** distinct screen positions of the pending picks, and their rays */
+	TArray<FVector2D> ScreenPositions;
+	TArray<FVector> RayOrigins;
+	TArray<FVector> RayDirections;
+
+	/** incremented on every flush, results of older flushes are ignored */
+	uint32 InFlightGeneration;
+
+	/** camera the in flight picks were traced from, and when */
+	FVector InFlightCameraLocation;
+	FRotator InFlightCameraRotation;
+	double InFlightTime;
+
+	/** results of past picks, oldest first */
+	TArray<FTDCCachedPick> CachedPicks;
+
+	/** picks answered from the cache this frame, and last frame's being delivered */
+	TArray<FTDCReadyPick> ReadyPicks;
+	TArray<FTDCReadyPick> LastFrameReadyPicks;
+	TArray<FTDCReadyPick> DeliveringPicks;
+
+	/** get the current camera transform */
+	void GetCameraTransform(FVector& OutLocation, FRotator& OutRotation) const;
+
+	/** find the cached pick of a screen position and channel traced from a camera, INDEX_NONE if there is none close enough */
+	int32 FindCachedPick(const FVector2D& ScreenPosition, ECollisionChannel Channel, const FVector& CameraLocation, const FRotator& CameraRotation) const;
+
+	/** can a cached pick still be delivered: young enough, and its hit actor still there? */
+	bool IsCachedPickValid(const FTDCCachedPick& CachedPick, double Now) const;
+
+	/** bound to OnTraceCompleted */
+	FTraceDelegate TraceDelegate;
+
+	/** async trace callback */
+	void OnTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+};
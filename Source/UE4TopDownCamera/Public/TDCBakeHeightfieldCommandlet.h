@@ -0,0 +1,35 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "Commandlets/Commandlet.h"
+#include "TDCBakeHeightfieldCommandlet.generated.h"
+
+/**
+ * Bakes the ground heights of a map and its streaming levels into heightfield files, one per level, read back at
+ * runtime by FTDCHeightfieldSampler.
+ *
+ * UE4Editor-Cmd.exe <Project> -run=TDCBakeHeightfield -Map=/Game/Maps/MyMap [-CellSize=100]
+ */
+UCLASS()
+class UE4TOPDOWNCAMERA_API UTDCBakeHeightfieldCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+
+	/*
+	 * Trace the ground of a level on a grid and write its heightfield.
+	 *
+	 * @param	World		World the level is loaded in, every level of the map visible.
+	 * @param	Level		Level to bake, only its actors are traced.
+	 * @param	LevelOffset	Translation of the level in the world.
+	 * @param	CellSize	Distance between two samples.
+	 * @returns	true if the heightfield was written or the level has nothing to bake
+	 */
+	bool BakeLevel(UWorld* World, ULevel* Level, const FVector& LevelOffset, float CellSize);
+};
@@ -3,8 +3,22 @@
 #pragma once
 
 #include "UE4TopDownCamera.h"
+#include "TDCNoScrollZones.h"
+#include "TDCCameraHelpers.h"
 #include "TDCCameraComponent.generated.h"
 
+/** ground area seen by a view, corners on the pan ground plane in order around it */
+struct FTDCCameraFootprint
+{
+	FVector2D Corners[4];
+};
+
+/** the view of the camera changed, with the ground area it now sees */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FTDCCameraViewChangedSignature, const FMinimalViewInfo& /*View*/, const FTDCCameraFootprint& /*Footprint*/);
+
+/** the view of the camera changed, for blueprints; the ground area is read with GetViewFootprint */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTDCCameraViewChangedDynamicSignature, FVector, ViewLocation, FRotator, ViewRotation);
+
 UCLASS(config=Game,BlueprintType, HideCategories=Trigger, meta=(BlueprintSpawnableComponent))
 class UE4TOPDOWNCAMERA_API UTDCCameraComponent : public UCameraComponent
 {
@@ -18,6 +32,13 @@ public:
 
 	// End UCameraComponent interface
 
+	// Begin UActorComponent interface
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// End UActorComponent interface
+
 	/** Handle zooming in. */
 	void OnZoomIn();
 
@@ -46,11 +67,29 @@ public:
 	FORCEINLINE void MoveRight(float Val) { MoveXYZ(EAxis::Y, Val); }
 	
 	/*
-	 * Exclude an area from the mouse scroll movement update. (This will be reset at the end of each update).
+	 * Exclude an area from the mouse scroll movement update until it is removed.
+	 * 
+	 * @param	InCoords	Screen coordinates of the area.
+	 * @returns	handle of the zone, to update or remove it
+	 */
+	int32 AddNoScrollZone( FBox InCoords );
+
+	/*
+	 * Move or resize an area excluded from the mouse scroll movement update.
 	 * 
-	 * @param	InCoords
+	 * @param	Handle		Handle returned by AddNoScrollZone.
+	 * @param	InCoords	New screen coordinates of the area.
+	 * @returns	true if the zone was found, false for a removed zone's handle
 	 */
-	void AddNoScrollZone( FBox InCoords );
+	bool UpdateNoScrollZone( int32 Handle, FBox InCoords );
+
+	/*
+	 * Stop excluding an area from the mouse scroll movement update.
+	 * 
+	 * @param	Handle		Handle returned by AddNoScrollZone.
+	 * @returns	true if the zone was found, false for a removed zone's handle
+	 */
+	bool RemoveNoScrollZone( int32 Handle );
 	
 	/*
 	 * CLamp the Camera location.
@@ -93,10 +132,50 @@ public:
 	UPROPERTY(config)
 	float DefaultZoomLevel;
 
+	/** Zoom levels set by a quick tap with three, four, ... fingers. */
+	UPROPERTY(config)
+	TArray<float> QuickZoomLevels;
+
 	/** Percentage of minimap where center of camera can be placed. */
 	UPROPERTY(config)
 	float MiniMapBoundsLimit;
 
+	/** Tag of the volumes that define the camera movement bounds. If there are none, the navmesh bounds or the level bounds are used. */
+	UPROPERTY(config)
+	FName CameraBoundsVolumeTag;
+
+	/*
+	 * Get the area of the ground plane seen by the camera, from the last view if it has one.
+	 * 
+	 * @param	InPlayerController	The player controller relative to this component.
+	 * @param	OutCorners			Corners of the area on the ground plane, in order around it.
+	 * @returns	true if the view could be projected
+	 */
+	bool GetGroundFootprint( const APlayerController* InPlayerController, FVector2D OutCorners[4] );
+
+	/** Broadcast when the view moves, zooms or turns; nothing is broadcast while the camera stays still. */
+	FTDCCameraViewChangedSignature OnCameraViewChanged;
+
+	/** Broadcast with OnCameraViewChanged, for blueprint minimaps and HUDs. */
+	UPROPERTY(BlueprintAssignable, Category = "Burnt Dragon")
+	FTDCCameraViewChangedDynamicSignature OnViewChanged;
+
+	/*
+	 * Get the ground area seen by the last view, as broadcast by OnViewChanged.
+	 *
+	 * @param	OutCorners	Corners of the area on the ground plane, in order around it.
+	 * @returns	true if the last view could be projected
+	 */
+	UFUNCTION(BluePrintCallable, Category = "Burnt Dragon")
+	bool GetViewFootprint( TArray<FVector2D>& OutCorners ) const;
+
+	/** How fast the view catches up with the focal location, as the camera lag of a spring arm; 0 to follow it exactly. Swipes always follow exactly. */
+	UPROPERTY(config, EditAnywhere, Category = "Burnt Dragon")
+	float FollowLagSpeed;
+
+	/** Jump the view to the focal location on the next update. */
+	void ResetFollow();
+
 	/** Bounds for camera movement. */
 	FBox CameraMovementBounds;
 
@@ -107,6 +186,14 @@ public:
 	UPROPERTY(config)
 	uint8 bShouldClampCamera : 1;
 
+	/** If set, swipe/drag panning follows uneven terrain: baked heightfields are ray marched where the levels have them, otherwise it traces against COLLISION_PANCAMERA on every update instead of using the ground plane. */
+	UPROPERTY(config)
+	uint8 bUsePanTraceFallback : 1;
+
+	/** Height of the ground plane swipe/drag panning is done on. */
+	UPROPERTY(config)
+	float PanGroundPlaneHeight;
+
 	/*
 	 * Handle the start of a 'pinch'. 
 	 *
@@ -131,6 +218,14 @@ public:
 	/** Sets the desired zoom level; clamping if necessary */
 	void SetZoomLevel(float NewLevel);
 
+	/*
+	 * Set the zoom level of a quick zoom preset.
+	 *
+	 * @param	PresetIndex		Index in QuickZoomLevels.
+	 * @returns	false if there is no such preset
+	 */
+	bool SetQuickZoomLevel(int32 PresetIndex);
+
 	/*
  	 * Handle the start swipe/drag
 	 *
@@ -177,17 +272,105 @@ private:
 	*/
 	void MoveXYZ(EAxis::Type Axis, float Val);
 
+	/*
+	 * Smooth the focal location the view is centered on.
+	 *
+	 * @param	FocalLocation	Focal location of the player controller.
+	 * @param	DeltaTime		Time since the last view.
+	 * @returns	location to center the view on
+	 */
+	FVector GetFollowLocation( const FVector& FocalLocation, float DeltaTime );
+
+	/*
+	 * Recompute the direction and offset of the view from the camera angle and zoom.
+	 *
+	 * @param	InPlayerController	The player controller relative to this component.
+	 */
+	void UpdateViewOffset( const APlayerController* InPlayerController );
+
+	/*
+	 * Intersect the corners of a view with the ground plane.
+	 *
+	 * @param	View			View to intersect.
+	 * @param	OutFootprint	Structure to receive the corners.
+	 * @returns	false if a corner of the view does not look down
+	 */
+	bool ComputeViewFootprint( const FMinimalViewInfo& View, FTDCCameraFootprint& OutFootprint ) const;
+
 	/** Return the pawn that owns this component. */
 	APawn* GetOwnerPawn();
 
 	/** Return the player controller of the pawn that owns this component. */
 	APlayerController* GetPlayerController();
 
-	/* Update the movement bounds of this component. */
+	/*
+	 * Scroll the camera when the mouse is in the border bands of the view.
+	 *
+	 * @param	MousePosition	Mouse position in the viewport.
+	 */
+	void UpdateEdgeScroll( const FVector2D& MousePosition );
+
+	/* Set the speed of the pawn movement used while edge scrolling. */
+	void SetEdgeScrollSpeed( float NewSpeed );
+
+	/* Border bands of the view the mouse can be in. */
+	enum EEdgeScrollBand
+	{
+		EdgeScrollBand_Left = 1,
+		EdgeScrollBand_Right = 2,
+		EdgeScrollBand_Top = 4,
+		EdgeScrollBand_Bottom = 8,
+	};
+
+	/* Border bands the mouse was in during the last update. */
+	uint8 EdgeScrollBands;
+
+	/* If set, the view rectangle is updated on the next camera movement update. */
+	uint8 bEdgeScrollViewDirty : 1;
+
+	/* View rectangle of the player in the viewport. */
+	FIntRect EdgeScrollViewRect;
+
+	/* Player the view rectangle belongs to. */
+	TWeakObjectPtr<ULocalPlayer> EdgeScrollPlayer;
+
+	/* Movement component of the owner pawn and its default speed. */
+	TWeakObjectPtr<UFloatingPawnMovement> EdgeScrollMovement;
+	float EdgeScrollDefaultSpeed;
+
+	/* Update the movement bounds of this component, from the cached playable bounds at the current zoom. */
 	void UpdateCameraBounds( const APlayerController* InPlayerController );
 
-	/* List of zones to exclude from scrolling during the camera movement update. */
-	TArray<FBox>	NoScrollZones;
+	/*
+	 * Get the bounds of the playable area of the level.
+	 *
+	 * @param	OutBounds	Structure to receive the bounds.
+	 * @returns	true if bounds were found
+	 */
+	bool GetPlayableBounds( FBox& OutBounds ) const;
+
+	/* Mark the movement bounds for update when a level is streamed in or out. */
+	void OnLevelsChanged( ULevel* InLevel, UWorld* InWorld );
+
+	/* Mark the movement bounds for update when the viewport is resized. */
+	void OnViewportResized( FViewport* InViewport, uint32 Unused );
+
+	/* If set, the movement bounds are updated on the next clamp. */
+	uint8 bCameraBoundsDirty : 1;
+
+	/* If set, the playable bounds are searched for again on the next movement bounds update. */
+	uint8 bPlayableBoundsDirty : 1;
+
+	/* Playable area of the loaded levels, invalid if none was found. Only changes when levels are streamed. */
+	FBox PlayableBounds;
+
+	/* Delegates marking the movement bounds for update. */
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+	FDelegateHandle ViewportResizedHandle;
+
+	/* Zones to exclude from scrolling during the camera movement update. */
+	FTDCNoScrollZones	NoScrollZones;
 	
 	/** Initial Zoom alpha when starting pinch. */
 	float InitialPinchAlpha;
@@ -197,5 +380,61 @@ private:
 
 	/** The initial position of the swipe/drag. */
 	FVector StartSwipeCoords;
+
+	/** Focal location the view follows with FollowLagSpeed. */
+	FVector FollowLocation;
+
+	/** If set, FollowLocation is valid. */
+	uint8 bHasFollowLocation : 1;
+
+	/** Camera angle and zoom the view offset was computed for. */
+	FRotator ViewAngle;
+	float ViewZoomAlpha;
+
+	/** Offset of the view from the focal location, along the camera angle. */
+	FVector ViewOffset;
+
+	/** Width over height of the view, for its footprint. */
+	float ViewAspectRatio;
+
+	/** Focal location and location of the last view. */
+	FVector ViewFocalLocation;
+	FVector ViewLocation;
+
+	/** Ground area seen by the last view. */
+	FTDCCameraFootprint ViewFootprint;
+
+	/** If set, ViewFootprint is valid. */
+	uint8 bHasViewFootprint : 1;
+
+	/** If set, the view offset is recomputed on the next view. */
+	uint8 bViewOffsetDirty : 1;
+
+	/** The ground plane used for the current swipe/drag. */
+	FPlane SwipeGroundPlane;
+
+	/** Scratch corners of the view and their rays for GetGroundFootprint, kept to not allocate per call. */
+	TArray<FVector2D> FootprintScreenPoints;
+	FTDCRayBatch FootprintRays;
+	FTDCPointBatch FootprintGroundPoints;
+
+	/** Pan queries issued since PanStatsWindowStart, for the per second stats. */
+	uint32 PanTracesInWindow;
+	uint32 PanIntersectionsInWindow;
+
+	/** Start time of the current per second stats window. */
+	double PanStatsWindowStart;
+
+	/*
+	 * Find the point on the ground under the given screen position.
+	 *
+	 * @param	SwipePosition		Screen position to check
+	 * @param	OutGroundPoint		Receives the point on the ground
+	 * @returns	true if the ground was found
+	 */
+	bool GetSwipeGroundPoint(const FVector2D& SwipePosition, FVector& OutGroundPoint);
+
+	/* Update the pan query stats. */
+	void CountPanQuery(bool bPhysicsTrace);
 };
 
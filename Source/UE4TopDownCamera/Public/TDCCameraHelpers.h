@@ -10,15 +10,118 @@
 #define COLLISION_PROJECTILE	ECC_GameTraceChannel2
 #define COLLISION_PANCAMERA		ECC_GameTraceChannel3
 
+/** projection state of a local player, reused until the camera or viewport changes */
+struct FTDCProjectionCache
+{
+	/** player the projection belongs to */
+	TWeakObjectPtr<class ULocalPlayer> Player;
+
+	/** camera and viewport state the projection was computed for */
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	float FOV;
+	FIntPoint ViewportSize;
+	FVector2D PlayerOrigin;
+	FVector2D PlayerSize;
+
+	/** constrained view rect and inverse view projection matrix */
+	FIntRect ViewRect;
+	FMatrix InvViewProjectionMatrix;
+
+	FTDCProjectionCache()
+		: ViewLocation(FVector::ZeroVector)
+		, ViewRotation(FRotator::ZeroRotator)
+		, FOV(0.0f)
+		, ViewportSize(FIntPoint::ZeroValue)
+		, PlayerOrigin(FVector2D::ZeroVector)
+		, PlayerSize(FVector2D::ZeroVector)
+		, InvViewProjectionMatrix(FMatrix::Identity)
+	{
+	}
+};
+
+/** rays in structure of arrays layout, input of the batch intersection kernel */
+struct FTDCRayBatch
+{
+	TArray<float> OriginX;
+	TArray<float> OriginY;
+	TArray<float> OriginZ;
+	TArray<float> DirectionX;
+	TArray<float> DirectionY;
+	TArray<float> DirectionZ;
+
+	int32 Num() const { return OriginX.Num(); }
+
+	void SetNumUninitialized(int32 NewNum)
+	{
+		OriginX.SetNumUninitialized(NewNum, false);
+		OriginY.SetNumUninitialized(NewNum, false);
+		OriginZ.SetNumUninitialized(NewNum, false);
+		DirectionX.SetNumUninitialized(NewNum, false);
+		DirectionY.SetNumUninitialized(NewNum, false);
+		DirectionZ.SetNumUninitialized(NewNum, false);
+	}
+
+	void SetRay(int32 Index, const FVector& RayOrigin, const FVector& RayDirection)
+	{
+		OriginX[Index] = RayOrigin.X;
+		OriginY[Index] = RayOrigin.Y;
+		OriginZ[Index] = RayOrigin.Z;
+		DirectionX[Index] = RayDirection.X;
+		DirectionY[Index] = RayDirection.Y;
+		DirectionZ[Index] = RayDirection.Z;
+	}
+};
+
+/** points in structure of arrays layout, output of the batch intersection kernel */
+struct FTDCPointBatch
+{
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+
+	int32 Num() const { return X.Num(); }
+
+	void SetNumUninitialized(int32 NewNum)
+	{
+		X.SetNumUninitialized(NewNum, false);
+		Y.SetNumUninitialized(NewNum, false);
+		Z.SetNumUninitialized(NewNum, false);
+	}
+
+	FVector GetPoint(int32 Index) const { return FVector(X[Index], Y[Index], Z[Index]); }
+};
+
 class FTDCCameraHelpers
 {
 public:
 	/** convert point in screen space to ray in world space */
 	static bool DeprojectScreenToWorld(const FVector2D& ScreenPosition, class ULocalPlayer* Player, FVector& RayOrigin, FVector& RayDirection);
 
+	/** convert points in screen space to rays in world space, sharing one projection */
+	static bool DeprojectScreenToWorldBatch(const TArray<FVector2D>& ScreenPositions, class ULocalPlayer* Player, TArray<FVector>& RayOrigins, TArray<FVector>& RayDirections);
+
+	/** get the projection of the player, recomputing it only if the camera or viewport changed */
+	static const FTDCProjectionCache* GetProjectionCache(class ULocalPlayer* Player);
+
+	/** force the next deprojection to recompute the projection */
+	static void InvalidateProjectionCache();
+
 	/** find intersection of ray in world space with ground plane */
 	static FVector IntersectRayWithPlane(const FVector& RayOrigin, const FVector& RayDirection, const FPlane& Plane);
 
+	/** find intersections of rays in world space with ground plane, four rays at a time */
+	static void IntersectRaysWithPlane(const FTDCRayBatch& Rays, const FPlane& Plane, FTDCPointBatch& OutPoints);
+
+	/** convert points in screen space to points on the ground plane, ScratchRays is owned by the caller so steady state batches do not allocate */
+	static bool DeprojectScreenToGroundBatch(const TArray<FVector2D>& ScreenPositions, class ULocalPlayer* Player, const FPlane& GroundPlane, FTDCRayBatch& ScratchRays, FTDCPointBatch& OutPoints);
+
+	/** winding of a convex quad, 1 or -1, to pass to IsInsideConvexQuad */
+	static float GetQuadWinding(const FVector2D Corners[4]);
+
+	/** is the point on the inner side of every edge of the convex quad? */
+	static bool IsInsideConvexQuad(const FVector2D Corners[4], float Winding, const FVector2D& Point);
+
 	/** create alpha map from UTexture2D for hit-tests in Slate */
 	static TSharedPtr<TArray<uint8>> CreateAlphaMapFromTexture(UTexture2D* Texture);
 
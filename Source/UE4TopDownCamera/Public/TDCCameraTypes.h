@@ -16,6 +16,11 @@ namespace EGameKey
 		Swipe,
 		SwipeTwoPoints,
 		Pinch,
+		SwipeMultiPoints,
+		TapMultiPoints,
+
+		/** number of game keys */
+		MAX,
 	};
 }
 
@@ -13,16 +13,50 @@ class UE4TOPDOWNCAMERA_API ATDCCharacter : public ACharacter
 {
 	GENERATED_UCLASS_BODY()
 
-	/* Called every frame */
-	virtual void Tick(float DeltaSeconds) override;
-
 	/* Called to bind functionality to input */
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 
+	virtual void BeginPlay() override;
+
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	/* Keeps the selection index up to date while the character moves */
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/* Make the character selectable by tap and marquee */
+	void RegisterSelectable();
+
+	/* Remove the character from the selection index */
+	void UnregisterSelectable();
+
+	/* Handle in the selection index of the world, INDEX_NONE when not registered */
+	int32 SelectionHandle;
+
+	/* Let the significance manager of the world drive the tick rates of the character */
+	void RegisterSignificance();
+
+	/* Remove the character from the significance manager, waking it up */
+	void UnregisterSignificance();
+
+	/* Handle in the significance manager of the world, INDEX_NONE when not registered */
+	int32 SignificanceHandle;
+
 public:
 
+	/* Park the character in the character pool or bring it back: hidden, without collision, movement and animation
+	   while pooled, with its movement and animation state reset when it comes back */
+	void SetPooled(bool bPooled);
+
+	/* The character died: the player controller owning it despawns it back to the character pool, other characters are destroyed */
+	UFUNCTION(BlueprintCallable, Category = "Burnt Dragon")
+	void Die();
+
+	/* Falling out of the world is a death, not a destroy */
+	virtual void FellOutOfWorld(const class UDamageType& DmgType) override;
+
+	/* Restart the ticking of a character put to sleep by the significance manager, e.g. when it is given a move or selected */
+	void WakeUp();
+
 	/************************************************************************/
 	/* Movement                                                             */
 	/************************************************************************/
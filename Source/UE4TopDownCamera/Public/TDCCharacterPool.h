@@ -0,0 +1,76 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+#include "TDCCharacter.h"
+#include "TDCAIController.h"
+
+/**
+ * Characters of a world with the AI controllers possessing them, kept around instead of destroyed.
+ * Spawning a pair registers their components, creates the anim instance and possesses the pawn, which hitches on
+ * respawn; a pooled pair is only hidden and stopped, and brought back with its movement, animation and path reset.
+ */
+class UE4TOPDOWNCAMERA_API FTDCCharacterPool
+{
+public:
+
+	explicit FTDCCharacterPool(UWorld* InWorld);
+
+	~FTDCCharacterPool();
+
+	/** pool of the world */
+	static FTDCCharacterPool& Get(UWorld* World) { return TTDCWorldRegistry<FTDCCharacterPool>::Get(World); }
+
+	/** spawn pooled pairs until the pool has made at least Count of them */
+	void Prewarm(int32 Count);
+
+	/*
+	 * Take a character and its controller out of the pool, spawning them if the pool is empty.
+	 *
+	 * @param	SpawnTransform	Where the character appears.
+	 * @param	Owner			Owner of the character and the controller.
+	 * @param	OutCharacter	The character, possessed by OutController.
+	 * @param	OutController	The controller.
+	 * @returns	false if nothing could be spawned
+	 */
+	bool Acquire(const FTransform& SpawnTransform, AActor* Owner, ATDCCharacter*& OutCharacter, ATDCAIController*& OutController);
+
+	/** put a character taken from the pool back, with its controller */
+	void Release(ATDCCharacter* Character, ATDCAIController* Controller);
+
+	/** pairs waiting in the pool */
+	int32 NumFree() const { return FreePairs.Num(); }
+
+	/** acquisitions served from the pool */
+	int32 GetNumHits() const { return NumHits; }
+
+	/** acquisitions that had to spawn */
+	int32 GetNumMisses() const { return NumMisses; }
+
+private:
+
+	struct FPair
+	{
+		TWeakObjectPtr<ATDCCharacter> Character;
+		TWeakObjectPtr<ATDCAIController> Controller;
+	};
+
+	/** spawn a character and the controller possessing it */
+	bool SpawnPair(const FTransform& SpawnTransform, AActor* Owner, ESpawnActorCollisionHandlingMethod CollisionHandling, FPair& OutPair);
+
+	/** update the pool stats */
+	void UpdateStats() const;
+
+	UWorld* World;
+
+	TArray<FPair> FreePairs;
+
+	/** pairs made by the pool, in use or not */
+	int32 NumSpawned;
+
+	int32 NumHits;
+
+	int32 NumMisses;
+};
@@ -0,0 +1,210 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** samples per side of a heightfield tile */
+#define TDC_HEIGHTFIELD_TILE_SIZE 64
+
+/** header of a baked heightfield file, followed by the tile table and the tile samples */
+struct FTDCHeightfieldHeader
+{
+	uint32 Magic;
+	uint32 Version;
+
+	/** location of the first sample, at the baked level offset */
+	float OriginX;
+	float OriginY;
+
+	/** distance between two samples */
+	float CellSize;
+
+	int32 NumTilesX;
+	int32 NumTilesY;
+
+	/** range of the heights in the file */
+	float MinHeight;
+	float MaxHeight;
+
+	/** translation of the streaming level when it was baked */
+	float LevelOffsetX;
+	float LevelOffsetY;
+	float LevelOffsetZ;
+};
+
+/** tile table entry of a baked heightfield */
+struct FTDCHeightfieldTile
+{
+	/** ETDCHeightfieldTile */
+	uint32 Type;
+
+	/** offset of the samples in the file, for quantized tiles */
+	uint32 DataOffset;
+
+	/** height of a sample: MinHeight + Sample * HeightScale */
+	float MinHeight;
+	float HeightScale;
+};
+
+namespace ETDCHeightfieldTile
+{
+	enum Type
+	{
+		/** no ground anywhere in the tile */
+		Empty,
+		/** one height for the whole tile */
+		Flat,
+		/** 16 bit samples, 0xFFFF where there is no ground */
+		Quantized,
+	};
+}
+
+/**
+ * Ground heights of one level, baked by the TDCBakeHeightfield commandlet.
+ * The file is tiled: tiles without ground or with a single height store no samples, the others store their samples
+ * quantized to 16 bits. The file is memory-mapped where the platform allows it.
+ */
+class UE4TOPDOWNCAMERA_API FTDCHeightfield
+{
+public:
+
+	~FTDCHeightfield();
+
+	/** open a baked heightfield, NULL if it does not exist or is not valid */
+	static TUniquePtr<FTDCHeightfield> Open(const FString& Filename);
+
+	/*
+	 * Bake heights into a heightfield file.
+	 *
+	 * @param	Filename		File to write.
+	 * @param	Origin			Location of the first sample, at LevelOffset.
+	 * @param	CellSize		Distance between two samples.
+	 * @param	NumTilesX		Tiles along X, the samples are NumTilesX * TDC_HEIGHTFIELD_TILE_SIZE wide.
+	 * @param	NumTilesY		Tiles along Y.
+	 * @param	LevelOffset		Translation of the level when it was baked.
+	 * @param	Heights			Heights row by row, MAX_flt where there is no ground.
+	 * @returns	true if the file was written
+	 */
+	static bool Write(const FString& Filename, const FVector2D& Origin, float CellSize, int32 NumTilesX, int32 NumTilesY, const FVector& LevelOffset, const TArray<float>& Heights);
+
+	/** bilinear height at a world location, false outside the heightfield or next to a hole */
+	bool GetHeight(const FVector2D& Location, float& OutHeight) const;
+
+	/** range of the heights, in world space */
+	float GetMinHeight() const { return Header->MinHeight + Offset.Z; }
+	float GetMaxHeight() const { return Header->MaxHeight + Offset.Z; }
+
+	/** distance between two samples */
+	float GetCellSize() const { return Header->CellSize; }
+
+	/** width of a tile, in world units */
+	float GetTileExtent() const { return Header->CellSize * TDC_HEIGHTFIELD_TILE_SIZE; }
+
+	/** area covered by the samples, in world space */
+	FBox2D GetBounds() const;
+
+	/** level offset the heightfield was baked at */
+	FVector GetBakedLevelOffset() const { return FVector(Header->LevelOffsetX, Header->LevelOffsetY, Header->LevelOffsetZ); }
+
+	/** translation from the baked level offset to the current one */
+	FVector Offset;
+
+private:
+
+	FTDCHeightfield();
+
+	/** read the header and tile table from the file data */
+	bool Init(const uint8* InData, int64 InSize);
+
+	/** height of a sample, false where there is no ground */
+	bool GetSample(int32 X, int32 Y, float& OutHeight) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** file data when it cannot be mapped */
+	TArray<uint8> LoadedData;
+
+	const uint8* Data;
+	const FTDCHeightfieldHeader* Header;
+	const FTDCHeightfieldTile* Tiles;
+};
+
+/**
+ * Baked heightfields of the levels loaded in a world.
+ * Heightfields are opened and closed as their levels stream in and out; where they overlap the highest ground wins.
+ * They are indexed by cells as wide as their largest tile, so a query only samples the heightfields of its cell.
+ * Answers ground queries from the camera without physics traces.
+ */
+class UE4TOPDOWNCAMERA_API FTDCHeightfieldSampler
+{
+public:
+
+	explicit FTDCHeightfieldSampler(UWorld* InWorld);
+
+	~FTDCHeightfieldSampler();
+
+	/** sampler of the world */
+	static FTDCHeightfieldSampler& Get(UWorld* World) { return TTDCWorldRegistry<FTDCHeightfieldSampler>::Get(World); }
+
+	/** baked heightfield file of a level package */
+	static FString GetHeightfieldFilename(const FString& LevelPackageName);
+
+	/** is any heightfield loaded? */
+	bool HasData() const { return Heightfields.Num() > 0; }
+
+	/** ground height at a location, false if no heightfield covers it */
+	bool GetHeight(const FVector2D& Location, float& OutHeight) const;
+
+	/*
+	 * March a ray over the heightfields.
+	 *
+	 * @param	RayOrigin		Start of the ray.
+	 * @param	RayDirection	Normalized direction of the ray, pointing down.
+	 * @param	OutGroundPoint	Where the ray meets the ground.
+	 * @returns	false if the ray does not meet a heightfield
+	 */
+	bool Raycast(const FVector& RayOrigin, const FVector& RayDirection, FVector& OutGroundPoint) const;
+
+private:
+
+	/** open the heightfield of a level */
+	void AddLevel(ULevel* Level);
+
+	void OnLevelAdded(ULevel* Level, UWorld* InWorld);
+
+	void OnLevelRemoved(ULevel* Level, UWorld* InWorld);
+
+	/** rebuild the cells and the range of the heights */
+	void UpdateIndex();
+
+	/** cell of the index at a location */
+	FIntPoint GetCell(const FVector2D& Location) const;
+
+	UWorld* World;
+
+	/** heightfields by level, only levels with a baked heightfield */
+	TMap<ULevel*, TUniquePtr<FTDCHeightfield>> Heightfields;
+
+	/** heightfields overlapping each cell, usually one */
+	TMap<FIntPoint, TArray<const FTDCHeightfield*, TInlineAllocator<1>>> Cells;
+
+	/** width of a cell of the index */
+	float IndexCellSize;
+
+	/** range of the heights of all heightfields */
+	float MinHeight;
+	float MaxHeight;
+
+	/** smallest cell size, the ray march step */
+	float MinCellSize;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+};
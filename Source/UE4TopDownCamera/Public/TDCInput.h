@@ -7,6 +7,7 @@
 
 DECLARE_DELEGATE_TwoParams(FOnePointActionSignature, const FVector2D&, float);
 DECLARE_DELEGATE_ThreeParams(FTwoPointsActionSignature, const FVector2D&, const FVector2D&, float);
+DECLARE_DELEGATE_ThreeParams(FMultiPointsActionSignature, const FVector2D&, int32, float);
 
 #define BIND_1P_ACTION(Handler, ActionKey, ActionEvent, Delegate)	\
 { \
@@ -14,6 +15,7 @@ DECLARE_DELEGATE_ThreeParams(FTwoPointsActionSignature, const FVector2D&, const
 	Handler->ActionBindings1P[Idx].Key = ActionKey; \
 	Handler->ActionBindings1P[Idx].KeyEvent = ActionEvent; \
 	Handler->ActionBindings1P[Idx].ActionDelegate.BindUObject(this, Delegate); \
+	Handler->RegisterActionBinding1P(Idx); \
 }
 
 #define BIND_2P_ACTION(Handler, ActionKey, ActionEvent, Delegate)	\
@@ -22,6 +24,16 @@ DECLARE_DELEGATE_ThreeParams(FTwoPointsActionSignature, const FVector2D&, const
 	Handler->ActionBindings2P[Idx].Key = ActionKey; \
 	Handler->ActionBindings2P[Idx].KeyEvent = ActionEvent; \
 	Handler->ActionBindings2P[Idx].ActionDelegate.BindUObject(this, Delegate); \
+	Handler->RegisterActionBinding2P(Idx); \
+}
+
+#define BIND_NP_ACTION(Handler, ActionKey, ActionEvent, Delegate)	\
+{ \
+	int32 Idx = Handler->ActionBindingsNP.AddZeroed(); \
+	Handler->ActionBindingsNP[Idx].Key = ActionKey; \
+	Handler->ActionBindingsNP[Idx].KeyEvent = ActionEvent; \
+	Handler->ActionBindingsNP[Idx].ActionDelegate.BindUObject(this, Delegate); \
+	Handler->RegisterActionBindingNP(Idx); \
 }
 
 struct FActionBinding1P
@@ -48,6 +60,18 @@ struct FActionBinding2P
 	FTwoPointsActionSignature ActionDelegate;
 };
 
+struct FActionBindingNP
+{
+	/** key to bind it to */
+	EGameKey::Type Key;
+
+	/** Key event to bind it to, e.g. pressed, released, dblclick */
+	TEnumAsByte<EInputEvent> KeyEvent;
+
+	/** action, called with the center of the points and the number of points */
+	FMultiPointsActionSignature ActionDelegate;
+};
+
 struct FSimpleKeyState
 {
 	/** current events indexed with: IE_Pressed, IE_Released, IE_Repeat */
@@ -65,12 +89,55 @@ struct FSimpleKeyState
 	/** accumulated down time */
 	float DownTime;
 
+	/** number of points associated with event (multi points actions only) */
+	int32 NumPoints;
+
 	FSimpleKeyState()
 	{
 		FMemory::Memzero(this, sizeof(FSimpleKeyState));
 	}
 };
 
+/** per touch state, indexed by touch key; only the entries of the touches in the active touch mask are read or written */
+struct FTouchPointsState
+{
+	/** current positions */
+	FVector2D Positions[EKeys::NUM_TOUCH_KEYS];
+
+	/** positions where the touches started */
+	FVector2D Anchors[EKeys::NUM_TOUCH_KEYS];
+
+	/** accumulated down times */
+	float DownTimes[EKeys::NUM_TOUCH_KEYS];
+
+	FTouchPointsState()
+	{
+		FMemory::Memzero(this, sizeof(FTouchPointsState));
+	}
+};
+
+/** touch (or mouse used as touch) event, timestamped by the device */
+struct FTouchSample
+{
+	/** time the event happened, in FPlatformTime::Seconds */
+	double Timestamp;
+
+	/** position of the touch */
+	FVector2D Position;
+
+	/** touch index */
+	uint8 Handle;
+
+	/** is the touch pressed after this event? */
+	uint8 bDown : 1;
+
+	/** does the event only move the touch? */
+	uint8 bMoved : 1;
+};
+
+/** capacity of the touch sample ring buffer, must be a power of two */
+#define TOUCH_SAMPLE_BUFFER_SIZE 256
+
 UCLASS()
 class UE4TOPDOWNCAMERA_API UTDCInput : public UObject
 {
@@ -81,45 +148,140 @@ public:
 	/** bindings for custom game events */
 	TArray<FActionBinding1P> ActionBindings1P;
 	TArray<FActionBinding2P> ActionBindings2P;
-
-	/** update detection */
-	void UpdateDetection(float DeltaTime);
-
-	/** get touch anchor position */
+	TArray<FActionBindingNP> ActionBindingsNP;
+
+	/** add binding to the dispatch table, called by BIND_1P_ACTION */
+	void RegisterActionBinding1P(int32 BindingIndex);
+
+	/** add binding to the dispatch table, called by BIND_2P_ACTION */
+	void RegisterActionBinding2P(int32 BindingIndex);
+
+	/** add binding to the dispatch table, called by BIND_NP_ACTION */
+	void RegisterActionBindingNP(int32 BindingIndex);
+
+	/*
+	 * Update detection.
+	 *
+	 * @param	DeltaTime	Frame time.
+	 * @param	CurrentTime	Time of the update, on the clock of the touch sample timestamps.
+	 */
+	void UpdateDetection(float DeltaTime, double CurrentTime);
+
+	/*
+	 * Queue a touch event for the next detection update.
+	 *
+	 * @param	Handle			Touch index.
+	 * @param	Type			Touch event.
+	 * @param	TouchLocation	Position of the touch.
+	 * @param	Timestamp		Time the event happened, from GetTouchSampleTime.
+	 */
+	void AddTouchSample(uint32 Handle, ETouchType::Type Type, const FVector2D& TouchLocation, double Timestamp);
+
+	/** time of a touch event on the FPlatformTime::Seconds clock, from the timestamp given by the device */
+	double GetTouchSampleTime(const FDateTime& DeviceTimestamp);
+
+	/** get anchor position of the i-th active touch */
 	FVector2D GetTouchAnchor(int32 i) const;
 
 protected:
 
-	/** game key states */
-	TMap<EGameKey::Type, FSimpleKeyState> KeyStateMap;
+	/** game key states, indexed with EGameKey */
+	FSimpleKeyState KeyStates[EGameKey::MAX];
 
-	/** touch anchors */
-	FVector2D TouchAnchors[2];
+	/** bindings to call for each game key and event, indexed with EGameKey and IE_Pressed, IE_Released, IE_Repeat */
+	TArray<int32, TInlineAllocator<1>> Dispatch1P[EGameKey::MAX][3];
+	TArray<int32, TInlineAllocator<1>> Dispatch2P[EGameKey::MAX][3];
+	TArray<int32, TInlineAllocator<1>> DispatchNP[EGameKey::MAX][3];
 
-	/** how long was touch 0 pressed? */
-	float Touch0DownTime;
+	/** game keys with events this frame, one bit per EGameKey */
+	uint32 DirtyKeys;
+
+	/** add event to game key state */
+	FSimpleKeyState& AddKeyEvent(EGameKey::Type Key, EInputEvent Event);
+
+	/** positions, anchors and down times of the touches */
+	FTouchPointsState TouchPoints;
 
 	/** how long was two points pressed? */
 	float TwoPointsDownTime;
 
+	/** touches used for the current two points actions */
+	int32 TwoPointsIndex[2];
+
 	/** max distance delta for current pinch */
 	float MaxPinchDistanceSq;
 
+	/** how long were multiple points pressed? */
+	float MultiPointsDownTime;
+
+	/** center of the multi points touch when its number of points last changed */
+	FVector2D MultiPointsAnchor;
+
+	/** number of points of the multi points touch when it was anchored */
+	int32 MultiPointsAnchorNumPoints;
+
+	/** most points of the current multi points touch */
+	int32 MaxMultiPoints;
+
+	/** did the current multi points touch move too far to be a tap? */
+	bool bMultiPointsMoved;
+
+	/** touch used for the one point actions, the first touch down until it is released */
+	int32 OnePointIndex;
+
+	/** did more touches come down during the one point touch? it is then not a tap */
+	bool bOnePointShared;
+
 	/** prev touch states for recognition */
 	uint32 PrevTouchState;
 
-	/** is two points touch active? */
-	bool bTwoPointsTouch;
+	/** touch events received since the last detection update */
+	FTouchSample TouchSamples[TOUCH_SAMPLE_BUFFER_SIZE];
+	uint32 TouchSamplesHead;
+	uint32 TouchSamplesTail;
+
+	/** touch states built from the touch events */
+	uint32 SampledTouchState;
+
+	/** set once touch events are received, detection then runs on them instead of the player input */
+	bool bUseTouchSamples;
+
+	/** time of the last detection step */
+	double LastDetectionTime;
+
+	/** FPlatformTime::Seconds minus the device time, for the quickest delivered event */
+	double DeviceClockOffset;
+
+	/** is DeviceClockOffset set? */
+	bool bHasDeviceClockOffset;
+
+	/** apply a touch event to the touch state without detection, when the queue is full */
+	void ApplyTouchSample(const FTouchSample& Sample);
+
+	/** is a touch with two or more points active? */
+	bool bMultiPointsTouch;
+
+	/** gather touch states and positions from the player input */
+	uint32 GatherTouchStates();
 
 	/** update game key recognition */
-	void UpdateGameKeys(float DeltaTime);
+	void UpdateGameKeys(float DeltaTime, uint32 CurrentTouchState);
 
-	/** process input state and call handlers */
-	void ProcessKeyStates(float DeltaTime);
+	/*
+	 * Process input state and call handlers.
+	 *
+	 * @param	DeltaTime			Time of the detection step.
+	 * @param	bDispatchRepeats	Dispatch the repeat events, otherwise they are kept for the last step of the frame
+	 *								so handlers get one repeat per frame, with the last position.
+	 */
+	void ProcessKeyStates(float DeltaTime, bool bDispatchRepeats);
 
 	/** detect one point actions (touch and mouse) */
-	void DetectOnePointActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition, FVector2D& AnchorPosition, float& DownTime);
+	void DetectOnePointActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition, const FVector2D& AnchorPosition, float DownTime);
 
 	/** detect two points actions (touch only) */
-	void DetectTwoPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, const FVector2D& CurrentPosition1, const FVector2D& CurrentPosition2);
+	void DetectTwoPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, int32 Index1, int32 Index2);
+
+	/** detect actions of three or more points (touch only) */
+	void DetectMultiPointsActions(bool bCurrentState, bool bPrevState, float DeltaTime, uint32 TouchState);
 };
@@ -0,0 +1,146 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+
+/** Touch event received before a frame, as queued for the gesture detection. */
+struct FTDCTouchEvent
+{
+	/** time of the event, on the clock of the detection */
+	double Timestamp;
+
+	/** position of the touch */
+	FVector2D Position;
+
+	/** touch index */
+	uint8 Handle;
+
+	/** ETouchType */
+	uint8 Type;
+};
+
+/** Input consumed by the gesture detection and the camera movement in one frame. */
+struct FTDCInputFrame
+{
+	/** delta time passed to ProcessPlayerInput */
+	float DeltaTime;
+
+	/** time the gesture detection runs at; when replaying, the recorded delta times added up */
+	double InputTime;
+
+	/** touch events received since the previous frame, in order */
+	TArray<FTDCTouchEvent> TouchEvents;
+
+	/** mouse position in the viewport, valid when bHasMousePosition is set */
+	FVector2D MousePosition;
+
+	bool bHasMousePosition;
+
+	/** size of the viewport in pixels */
+	FIntPoint ViewportSize;
+
+	/** PlayerInput->Touches, Z is the pressed state */
+	FVector Touches[EKeys::NUM_TOUCH_KEYS];
+
+	FTDCInputFrame();
+};
+
+/**
+ * Records the input of every frame to a file and plays it back.
+ *
+ * Recording is enabled with -TDCRecord=<file>. Replaying is enabled with -TDCReplay=<file>, usually together with
+ * -nullrhi -unattended -UseFixedTimeStep -FPS=<n>; the camera transform and timings of every frame are written as
+ * CSV to -TDCReplayOut=<file> and the game exits at the end of the recording.
+ *
+ * File layout: header (magic, version, number of touches), then one record per frame made of a packed mask of the
+ * fields that changed since the previous frame followed by those fields only. The touch events of a frame are
+ * stored with their time relative to the frame, so a replay feeds them to the detection with their own timing.
+ * The recording is closed when the engine exits, and flushed regularly in case it does not exit cleanly.
+ */
+class UE4TOPDOWNCAMERA_API FTDCInputRecorder
+{
+public:
+
+	/** recorder set up from the command line on first use */
+	static FTDCInputRecorder& Get();
+
+	~FTDCInputRecorder();
+
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	bool IsReplaying() const { return Reader.IsValid(); }
+
+	/** append a frame to the recording, with the touch events recorded since the previous one */
+	void RecordFrame(const FTDCInputFrame& Frame);
+
+	/** keep a touch event for the next recorded frame */
+	void RecordTouchEvent(uint32 Handle, ETouchType::Type Type, const FVector2D& Position, double Timestamp);
+
+	/**
+	 * Advance the replay by one frame.
+	 *
+	 * @returns	false at the end of the recording
+	 */
+	bool ReadFrame();
+
+	/** frame read last by ReadFrame */
+	const FTDCInputFrame& GetReplayFrame() const { return ReplayFrame; }
+
+	/** time spent in the input detection of the current frame */
+	void AddInputTime(double Seconds) { FrameInputSeconds += Seconds; }
+
+	/** time spent in the camera movement of the current frame */
+	void AddCameraTime(double Seconds) { FrameCameraSeconds += Seconds; }
+
+	/**
+	 * Write the results of the frame read last, call before reading the next one.
+	 * The camera is updated after the player tick, so its transform and timings are complete only then.
+	 */
+	void WriteReplayResult(const FVector& CameraLocation, const FRotator& CameraRotation);
+
+	/** close the files */
+	void Finish();
+
+private:
+
+	FTDCInputRecorder();
+
+	/** field bits of the per frame change mask, touches use the bits from ChangedTouch0 on */
+	enum
+	{
+		ChangedDeltaTime = 1 << 0,
+		ChangedMouse = 1 << 1,
+		ChangedViewportSize = 1 << 2,
+		HasTouchEvents = 1 << 3,
+		ChangedTouch0 = 1 << 4,
+	};
+
+	/** read or write the fields of Frame selected by ChangeMask, touch event times relative to FrameStartTime */
+	void SerializeFrame(FArchive& Ar, FTDCInputFrame& Frame, uint32 ChangeMask, double FrameStartTime);
+
+	TUniquePtr<FArchive> Writer;
+
+	TUniquePtr<FArchive> Reader;
+
+	TUniquePtr<FArchive> ResultsWriter;
+
+	/** last frame written, base of the delta encoding */
+	FTDCInputFrame PrevFrame;
+
+	/** last frame read */
+	FTDCInputFrame ReplayFrame;
+
+	/** touch events waiting for the next recorded frame */
+	TArray<FTDCTouchEvent> PendingTouchEvents;
+
+	/** number of frames written */
+	int32 RecordFrameIndex;
+
+	/** number of frames read */
+	int32 ReplayFrameIndex;
+
+	double FrameInputSeconds;
+
+	double FrameCameraSeconds;
+};
@@ -0,0 +1,90 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+
+/**
+ * Screen space areas excluded from camera scrolling.
+ * Zones stay registered until removed and are indexed by a uniform grid, so point queries only test the zones of one cell.
+ * Handles carry the serial number of their zone next to its slot, so a stale handle never reaches a zone added later in the same slot.
+ */
+class UE4TOPDOWNCAMERA_API FTDCNoScrollZones
+{
+public:
+
+	FTDCNoScrollZones();
+
+	/*
+	 * Register a zone.
+	 *
+	 * @param	InCoords	Screen coordinates of the zone (Z is ignored).
+	 * @returns	handle of the zone
+	 */
+	int32 Add(const FBox& InCoords);
+
+	/*
+	 * Move or resize a zone.
+	 *
+	 * @param	Handle		Handle returned by Add.
+	 * @param	InCoords	New screen coordinates of the zone.
+	 * @returns	true if the handle was valid
+	 */
+	bool Update(int32 Handle, const FBox& InCoords);
+
+	/*
+	 * Unregister a zone.
+	 *
+	 * @param	Handle		Handle returned by Add.
+	 * @returns	true if the handle was valid
+	 */
+	bool Remove(int32 Handle);
+
+	/** Unregister all zones. */
+	void Empty();
+
+	/*
+	 * Check if a screen position is inside any zone.
+	 *
+	 * @param	Position	Screen position to check.
+	 * @returns	true if the position is in a zone
+	 */
+	bool Contains(const FVector2D& Position) const;
+
+	/** Number of registered zones. */
+	int32 Num() const { return Zones.Num(); }
+
+private:
+
+	/** A registered zone and the serial number its handle must carry. */
+	struct FZone
+	{
+		FBox Coords;
+		int32 Serial;
+	};
+
+	/** Find the zone of a handle, NULL if the handle is stale or invalid. */
+	FZone* FindZone(int32 Handle);
+
+	/** Rebuild the grid after the zones changed. */
+	void RebuildGrid();
+
+	/** Registered zones, indexed by the slot part of the handles. */
+	TSparseArray<FZone> Zones;
+
+	/** Serial number given to the next zone. */
+	int32 NextSerial;
+
+	/** Slots of the zones overlapping each cell, row major. */
+	TArray<TArray<int32, TInlineAllocator<4>>> Cells;
+
+	/** Screen position of the first cell. */
+	FVector2D GridOrigin;
+
+	/** Number of cells on each axis. */
+	int32 GridSizeX;
+	int32 GridSizeY;
+
+	/** Size of a cell in pixels. */
+	float CellSize;
+};
@@ -6,6 +6,10 @@
 #include "TDCCharacter.h"
 #include "Camera.h"
 #include "TDCAIController.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "TDCAsyncPicker.h"
+#include "TDCStreamingPredictor.h"
+#include "TDCSpawnRegistry.h"
 #include "TDCPlayerController.generated.h"
 
 /**
@@ -16,8 +20,8 @@ class UE4TOPDOWNCAMERA_API ATDCPlayerController : public APlayerController
 {
 	GENERATED_UCLASS_BODY()
 
-	/* Spawns the main character of the game at the position of the first APlayerStart actor found in the world */
-	void SpawnMainCharacter();
+	/* Spawn point the main character was spawned at, released when the character goes away */
+	FTDCSpawnPointHandle MainCharacterSpawnPoint;
 
 	/* The main character of the game. It's spawned and maintained by the player controller */
 	ATDCCharacter* MainCharacter = nullptr;
@@ -33,6 +37,9 @@ class UE4TOPDOWNCAMERA_API ATDCPlayerController : public APlayerController
 
 	void MoveToMouseCursor();
 
+	/** move to the picked location */
+	void OnMouseCursorPicked(bool bBlockingHit, const FHitResult& Hit);
+
 	void MoveToTouchLocationPressed(const ETouchIndex::Type FingerIndex, const FVector Location);
 
 	void MoveToTouchLocationReleased(const ETouchIndex::Type FingerIndex, const FVector Location);
@@ -49,12 +56,72 @@ class UE4TOPDOWNCAMERA_API ATDCPlayerController : public APlayerController
 
 	void MoveRight(float Val);
 
-	void MoveMainCharacterToLocation(FVector& location);
+	/*
+	 * Issue a single path request for the main character, unless it is already moving to a goal within MoveCoalesceRadius.
+	 *
+	 * @param	Destination		Location to move to.
+	 * @param	bAsync			Find the path asynchronously, the character starts moving when it is found.
+	 * @returns	true if a path request was issued
+	 */
+	bool MoveMainCharacterToLocation(const FVector& Destination, bool bAsync = false);
+
+	/** submit an async path query for the main character, replacing the one in flight */
+	bool RequestMainCharacterPathAsync(const FVector& Destination);
+
+	/** async path query callback, follows the path unless a newer destination came in */
+	void OnMainCharacterPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	/** cancel the async path query in flight */
+	void AbortMainCharacterPathQuery();
+
+	/** the main character was destroyed by someone else, despawn what is left of it */
+	UFUNCTION()
+	void OnMainCharacterEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	/** id of the async path query in flight, INVALID_NAVQUERYID if none */
+	uint32 PendingPathQueryId;
+
+	/** goal of the last path request issued for the main character */
+	FVector MainCharacterMoveGoal;
+
+	/** number of move requests dropped because the main character was already moving close to their destination */
+	int32 NumCoalescedMoveRequests;
 
 	virtual void UpdateRotation(float DeltaTime) override;
 
 	virtual void ProcessPlayerInput(const float DeltaTime, const bool bGamePaused) override;
 
+	virtual bool InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad) override;
+
+	/** pick under the cursor and the touches for over events, throttled while the cursor is still */
+	void UpdateHover(float DeltaTime);
+
+	/** dispatch mouse over events */
+	void OnHoverPicked(bool bBlockingHit, const FHitResult& Hit);
+
+	/** dispatch touch over events */
+	void OnTouchOverPicked(bool bBlockingHit, const FHitResult& Hit, ETouchIndex::Type FingerIndex);
+
+	/** cursor position of the last hover pick */
+	FVector2D HoverScreenPosition;
+
+	/** time since the last hover trace */
+	float TimeSinceHoverTrace;
+
+	/** time since the significance of the actors was last updated */
+	float TimeSinceTickThrottle;
+
+	/** score the actors of the world and predict streaming from the current view */
+	void UpdateFromCameraView(float DeltaTime);
+
+	/** component that received the click being held */
+	TWeakObjectPtr<UPrimitiveComponent> ClickedComponent;
+
+	/** pass the input of this frame to the input recorder */
+	void RecordInputFrame(float DeltaTime, double InputTime);
+
+	virtual bool InputTouch(uint32 Handle, ETouchType::Type Type, const FVector2D& TouchLocation, float Force, FDateTime DeviceTimestamp, uint32 TouchpadIndex) override;
+
 protected:
 	/** if set, input and camera updates will be ignored */
 	uint8 bIgnoreInput : 1;
@@ -73,10 +140,29 @@ protected:
 	/** Previous swipe mid point. */
 	FVector2D PrevSwipeMidPoint;
 
+	/** Number of points of the previous multi points swipe update. */
+	int32 PrevSwipeNumPoints;
+
+	/*
+	 * Pan the spectator pawn towards where the mid point of a two or more points swipe moved since the last update.
+	 *
+	 * @param	SwipeMidPoint	Screen position of the mid point of the touches.
+	 * @param	NumPoints		Number of touches, every touch past the first adds the pan speed of a two points swipe.
+	 */
+	void PanMultiPointsSwipe(const FVector2D& SwipeMidPoint, int32 NumPoints);
+
 	/** Custom input handler. */
 	UPROPERTY()
 	class UTDCInput* InputHandler;
 
+	/** Picks under the cursor and touches, a frame late. */
+	UPROPERTY()
+	UTDCAsyncPicker* Picker;
+
+	/** Prefetches streaming where the camera is going. */
+	UPROPERTY()
+	UTDCStreamingPredictor* StreamingPredictor;
+
 	/** set desired camera position. */
 	void SetCameraTarget(const FVector& CameraTarget);
 
@@ -85,10 +171,14 @@ protected:
 	void OnHoldPressed(const FVector2D& ScreenPosition, float DownTime);
 	void OnHoldReleased(const FVector2D& ScreenPosition, float DownTime);
 	void OnSwipeStarted(const FVector2D& AnchorPosition, float DownTime);
+	void OnSwipeStartPicked(bool bBlockingHit, const FHitResult& Hit);
 	void OnSwipeUpdate(const FVector2D& ScreenPosition, float DownTime);
 	void OnSwipeReleased(const FVector2D& ScreenPosition, float DownTime);
 	void OnSwipeTwoPointsStarted(const FVector2D& ScreenPosition1, const FVector2D& ScreenPosition2, float DownTime);
 	void OnSwipeTwoPointsUpdate(const FVector2D& ScreenPosition1, const FVector2D& ScreenPosition2, float DownTime);
+	void OnSwipeMultiPointsStarted(const FVector2D& CenterPosition, int32 NumPoints, float DownTime);
+	void OnSwipeMultiPointsUpdate(const FVector2D& CenterPosition, int32 NumPoints, float DownTime);
+	void OnTapMultiPoints(const FVector2D& CenterPosition, int32 NumPoints, float DownTime);
 	void OnPinchStarted(const FVector2D& AnchorPosition1, const FVector2D& AnchorPosition2, float DownTime);
 	void OnPinchUpdate(const FVector2D& ScreenPosition1, const FVector2D& ScreenPosition2, float DownTime);
 
@@ -101,17 +191,27 @@ protected:
 	void SetSelectedActor(AActor* NewFocus, const FVector& NewPosition);
 
 	/**
-	* Get friendly target under screen space coordinates.
+	* Pick friendly target under screen space coordinates, the result comes in next frame.
 	*
 	* @param	ScreenPoint	Screen coordinates to check
-	* @param	WorldPoint	Point in the world the screen coordinates projected onto.
+	* @param	OnPicked	Called with the hit, its actor is the target.
 	*/
-	AActor* GetFriendlyTarget(const FVector2D& ScreenPoint, FVector& WorldPoint) const;
+	void PickFriendlyTarget(const FVector2D& ScreenPoint, const FTDCPickDelegate& OnPicked);
+
+	/** screen points of the current selection query, and their rays in world space */
+	TArray<FVector2D> SelectionScreenPoints;
+	TArray<FVector> SelectionRayOrigins;
+	TArray<FVector> SelectionRayDirections;
+
+	/** deproject SelectionScreenPoints to rays, the selection index tests them at the height of each actor */
+	bool DeprojectSelectionPoints();
 
 public:
 
 	void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	void PlayerTick(float DeltaTime);
 
 	void SetupInputComponent();
@@ -119,9 +219,80 @@ public:
 	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
 	float MinDistanceToMoveCharacter;
 
+	/** if set, mouse and touch over events are dispatched from the cursor pick cache (replaces bEnableMouseOverEvents and bEnableTouchOverEvents) */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	bool bDispatchOverEvents;
+
+	/** if set, click events are dispatched to the hovered component (replaces bEnableClickEvents) */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	bool bDispatchClickEvents;
+
+	/** hover traces per second while the cursor and the camera are still */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	float HoverTraceRate;
+
+	/** cursor moves smaller than this, in pixels, reuse the cached pick */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	float CursorCacheEpsilon;
+
+	/** if set, click/tap-to-move finds paths asynchronously instead of stalling the game thread */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	bool bUseAsyncPathfinding;
+
+	/** move requests closer than this to the current goal of the main character are dropped */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	float MoveCoalesceRadius;
+
+	/** if set, levels, textures and navmesh tiles are streamed in where the camera is going */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	bool bPredictStreaming;
+
+	/** how far ahead, in seconds, the camera is predicted for streaming */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	float StreamingLookAheadTime;
+
+	/** most actors ticking at full rate, the ones near the focal point and largest on screen */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	int32 MaxHighSignificanceActors;
+
+	/** how many times per second the tick rates of the actors are throttled by the camera view, 0 for never */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	float TickThrottleRate;
+
+	/** number of character and AI controller pairs spawned into the character pool when the map starts */
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Burnt Dragon")
+	int32 CharacterPoolSize;
+
+	/** number of move requests dropped since the game started */
+	int32 GetNumCoalescedMoveRequests() const { return NumCoalescedMoveRequests; }
+
 	UFUNCTION(BluePrintCallable, Category = "Burnt Dragon")
 	void SetNewMoveDestination(FVector DestLocation);
 
+	/* Spawns the main character of the game at a free spawn point around the APlayerStart actors of the world */
+	UFUNCTION(BluePrintCallable, Category = "Burnt Dragon")
+	void SpawnMainCharacter();
+
+	/* Gives the main character and its AI Controller back to the character pool of the world, e.g. when it dies */
+	UFUNCTION(BluePrintCallable, Category = "Burnt Dragon")
+	void DespawnMainCharacter();
+
+	/* The main character, NULL while it is despawned */
+	ATDCCharacter* GetMainCharacter() const { return MainCharacter; }
+
+	/** Selectable actor under screen coordinates, found in the selection index without physics traces. */
+	AActor* PickSelectableActor(const FVector2D& ScreenPosition);
+
+	/**
+	 * Marquee selection: selectable actors standing inside a screen rectangle.
+	 *
+	 * @param	FirstCorner		Corner where the marquee started.
+	 * @param	SecondCorner	Opposite corner.
+	 * @param	OutActors		Selected actors.
+	 */
+	UFUNCTION(BluePrintCallable, Category = "Burnt Dragon")
+	void SelectActorsInScreenRect(const FVector2D& FirstCorner, const FVector2D& SecondCorner, TArray<AActor*>& OutActors);
+
 	/** Helper to return cast version of Spectator pawn. */
 	class ATDCSpectatorPawn* GetSpectatorPawn() const;
 
@@ -0,0 +1,104 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+
+/**
+ * Selectable actors of a world, projected onto the ground plane.
+ * Actors are kept in a loose hashed grid by their ground location and moved between cells when they cross one,
+ * so tap picking and marquee selection only visit the cells they cover.
+ * Queries take view rays and test each actor where the rays cross its own height, so an actor is picked where it is
+ * drawn and not where the ray reaches the ground below it.
+ */
+class UE4TOPDOWNCAMERA_API FTDCSelectionIndex
+{
+public:
+
+	explicit FTDCSelectionIndex(UWorld* InWorld);
+
+	/** index of the world */
+	static FTDCSelectionIndex& Get(UWorld* World) { return TTDCWorldRegistry<FTDCSelectionIndex>::Get(World); }
+
+	/*
+	 * Register a selectable actor.
+	 *
+	 * @param	Actor		Actor to select.
+	 * @param	Radius		Ground radius the actor can be picked within.
+	 * @returns	handle of the actor
+	 */
+	int32 Add(AActor* Actor, float Radius);
+
+	/** move a selectable actor, only touches the grid when it changes cell */
+	void Update(int32 Handle, const FVector& Location);
+
+	/** unregister a selectable actor */
+	void Remove(int32 Handle);
+
+	/*
+	 * Closest actor to a view ray, tested at the height of each actor.
+	 *
+	 * @param	RayOrigin		Origin of the ray in world space.
+	 * @param	RayDirection	Direction of the ray, pointing down.
+	 * @returns	the actor whose radius contains the ray at its height, NULL if none
+	 */
+	AActor* FindAlongRay(const FVector& RayOrigin, const FVector& RayDirection) const;
+
+	/*
+	 * Actors inside the view rays of the corners of a screen rectangle, tested at the height of each actor.
+	 *
+	 * @param	RayOrigins		Origins of the corner rays, in order around the rectangle.
+	 * @param	RayDirections	Directions of the corner rays, pointing down.
+	 * @param	OutActors		Actors inside the rays (appended).
+	 */
+	void FindInRays(const FVector RayOrigins[4], const FVector RayDirections[4], TArray<AActor*>& OutActors) const;
+
+	/** number of selectable actors */
+	int32 Num() const { return Entries.Num(); }
+
+private:
+
+	struct FEntry
+	{
+		/** selectable actor */
+		TWeakObjectPtr<AActor> Actor;
+
+		/** ground location */
+		FVector2D Location;
+
+		/** height of the actor location, where queries test it */
+		float Height;
+
+		/** pick radius */
+		float Radius;
+
+		/** cell the entry is stored in */
+		FIntPoint Cell;
+	};
+
+	/** cell of a ground location */
+	FIntPoint GetCell(const FVector2D& Location) const;
+
+	/** call Function with the entry handles of every used cell between MinCell and MaxCell */
+	template<typename FunctionType>
+	void VisitCells(const FIntPoint& MinCell, const FIntPoint& MaxCell, FunctionType Function) const;
+
+	/** track the height range of the entries */
+	void AddHeight(float Height);
+
+	TSparseArray<FEntry> Entries;
+
+	/** entry handles per cell, only cells with entries exist */
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<8>>> Cells;
+
+	/** size of a cell in world units */
+	float CellSize;
+
+	/** largest pick radius, how far point queries look into the neighbour cells */
+	float MaxRadius;
+
+	/** lowest and highest entry heights seen, the heights where queries look for cells */
+	float MinHeight;
+	float MaxHeight;
+};
@@ -0,0 +1,134 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+#include "TDCTickThrottle.h"
+
+namespace ETDCSignificance
+{
+	/** one bucket per band of the tick throttle, with its tick settings */
+	enum Type
+	{
+		/** in view and near the focal point or large on screen, ticks every frame, limited by the budget */
+		High = ETDCTickBand::NearInView,
+		/** in view */
+		Medium = ETDCTickBand::FarInView,
+		/** out of view, near the focal point or large enough on screen */
+		Low = ETDCTickBand::NearOutOfView,
+		/** out of view and far, may sleep */
+		Dormant = ETDCTickBand::FarOutOfView,
+		Num = ETDCTickBand::Num
+	};
+}
+
+/**
+ * Significance of the actors of a world, scored from the top down camera.
+ * The tick throttle bands of the world are refined by the size of each actor on screen and a budget of actors
+ * ticking every frame; dormant actors may sleep while they are idle.
+ */
+class UE4TOPDOWNCAMERA_API FTDCSignificanceManager
+{
+public:
+
+	explicit FTDCSignificanceManager(UWorld* InWorld);
+
+	/** manager of the world */
+	static FTDCSignificanceManager& Get(UWorld* World) { return TTDCWorldRegistry<FTDCSignificanceManager>::Get(World); }
+
+	/*
+	 * Register an actor with the manager and the tick throttle, it ticks at full rate until the next update.
+	 *
+	 * @param	Actor			Actor to score.
+	 * @param	Radius			Radius of the actor, its size on screen is scored.
+	 * @param	bAllowSleep		If set, the components of the actor stop ticking while it is dormant and idle.
+	 * @returns	handle of the actor
+	 */
+	int32 Register(AActor* Actor, float Radius, bool bAllowSleep);
+
+	/** unregister an actor, waking it up if it sleeps */
+	void Unregister(int32 Handle);
+
+	/** wake up a sleeping actor now rather than on the next update, e.g. when it is given a move */
+	void Wake(int32 Handle);
+
+	/*
+	 * Score the actors against the current view and move them between buckets.
+	 *
+	 * @param	ViewLocation	Location of the camera.
+	 * @param	TanHalfFOV		Tangent of half the horizontal field of view.
+	 * @param	FocalPoint		Point the camera looks at.
+	 * @param	Footprint		Corners of the ground area seen by the camera, in order around it.
+	 */
+	void Update(const FVector& ViewLocation, float TanHalfFOV, const FVector& FocalPoint, const FVector2D Footprint[4]);
+
+	/** bucket of a registered actor */
+	ETDCSignificance::Type GetSignificance(int32 Handle) const;
+
+	/** number of actors in a bucket, as of the last update */
+	int32 GetNumInBucket(ETDCSignificance::Type Significance) const { return NumInBucket[Significance]; }
+
+	/** number of sleeping actors */
+	int32 GetNumSleeping() const { return NumSleeping; }
+
+	/** the most actors in the high significance bucket, the others are medium */
+	int32 MaxHighSignificance;
+
+	/** screen size, as a fraction of half the view width, that makes an actor in view high significance */
+	float HighScreenSize;
+
+	/** screen size that keeps an actor out of view low significance rather than dormant */
+	float LowScreenSize;
+
+private:
+
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		float Radius;
+
+		/** handle in the tick throttle */
+		int32 TickThrottleHandle;
+
+		/** bucket as of the last update, Num if none */
+		ETDCSignificance::Type Significance;
+
+		uint8 bAllowSleep : 1;
+
+		/** components are not ticking */
+		uint8 bSleeping : 1;
+	};
+
+	/** put an entry in a bucket */
+	void SetSignificance(FTDCTickThrottle& TickThrottle, FEntry& Entry, ETDCSignificance::Type Significance);
+
+	/** stop or restart the ticking of the components of an actor */
+	static void SetSleeping(AActor* Actor, bool bSleeping);
+
+	/** is the actor moving or about to? */
+	static bool IsActive(AActor* Actor);
+
+	/** wake up or put to sleep a dormant entry */
+	void UpdateSleep(FEntry& Entry, AActor* Actor);
+
+	/** world of the tick throttle */
+	UWorld* World;
+
+	TSparseArray<FEntry> Entries;
+
+	/** scratch list of the high significance candidates, kept to not allocate per frame */
+	struct FCandidate
+	{
+		int32 Handle;
+		float ScreenSize;
+		/** near the focal point, wins over any screen size */
+		bool bNearFocalPoint;
+	};
+	TArray<FCandidate> HighCandidates;
+
+	int32 NumInBucket[ETDCSignificance::Num];
+
+	int32 NumSleeping;
+};
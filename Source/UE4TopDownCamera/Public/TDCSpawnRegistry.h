@@ -0,0 +1,98 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+
+/** spawn point handed out by FTDCSpawnRegistry */
+struct FTDCSpawnPointHandle
+{
+	/** player start the spawn point belongs to */
+	int32 StartIndex;
+
+	/** slot around the player start */
+	int32 SlotIndex;
+
+	FTDCSpawnPointHandle()
+		: StartIndex(INDEX_NONE)
+		, SlotIndex(INDEX_NONE)
+	{
+	}
+
+	bool IsValid() const { return StartIndex != INDEX_NONE; }
+};
+
+/**
+ * Player starts of a world and the spawn points handed out around them.
+ * Every player start owns rings of slots around it; spawns go round-robin over the starts and take the first free
+ * slot that is not blocked, placed on the ground found below it. Rings are added as the inner ones fill up, until a
+ * ring has no claimed slot and every other slot of it is blocked: the start is walled in.
+ */
+class UE4TOPDOWNCAMERA_API FTDCSpawnRegistry
+{
+public:
+
+	explicit FTDCSpawnRegistry(UWorld* InWorld);
+
+	~FTDCSpawnRegistry();
+
+	/** registry of the world */
+	static FTDCSpawnRegistry& Get(UWorld* World) { return TTDCWorldRegistry<FTDCSpawnRegistry>::Get(World); }
+
+	/*
+	 * Claim a free spawn point for a capsule.
+	 *
+	 * @param	Radius			Radius of the capsule.
+	 * @param	HalfHeight		Half height of the capsule.
+	 * @param	OutTransform	Where to spawn, the capsule rests on the ground.
+	 * @param	OutHandle		Handle to release the spawn point with.
+	 * @returns	false if every slot is taken or blocked
+	 */
+	bool ClaimSpawnPoint(float Radius, float HalfHeight, FTransform& OutTransform, FTDCSpawnPointHandle& OutHandle);
+
+	/** give a spawn point back once its actor has moved away or is gone */
+	void ReleaseSpawnPoint(FTDCSpawnPointHandle& Handle);
+
+	/** number of indexed player starts */
+	int32 Num() const { return Starts.Num(); }
+
+private:
+
+	struct FStart
+	{
+		/** the player start, NULL once its level is gone */
+		TWeakObjectPtr<APlayerStart> PlayerStart;
+
+		/** location and rotation of the player start */
+		FVector Location;
+		FRotator Rotation;
+
+		/** claimed slots, grown a ring at a time */
+		TBitArray<> ClaimedSlots;
+	};
+
+	/** index the player starts of a level */
+	void AddLevel(ULevel* Level);
+
+	void OnLevelAdded(ULevel* Level, UWorld* InWorld);
+
+	void OnLevelRemoved(ULevel* Level, UWorld* InWorld);
+
+	/** location of a slot relative to its player start, ring k holds 6k slots */
+	static FVector2D GetSlotOffset(int32 Ring, int32 SlotInRing, float Spacing);
+
+	/** ground height below a location, from a trace against world geometry or else the navmesh */
+	bool FindGroundHeight(const FVector& Location, float& OutGroundZ) const;
+
+	UWorld* World;
+
+	TArray<FStart> Starts;
+
+	/** start the next claim begins with */
+	int32 NextStartIndex;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+};
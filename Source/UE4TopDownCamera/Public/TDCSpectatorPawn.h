@@ -25,8 +25,22 @@ private:
 	UPROPERTY(Category = CameraActor, EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
 	bool bFollowMainCharacter;
 
+	/* If set, the camera boom does not tick, lag or test collision; the camera component frames and smooths the view on its own */
+	UPROPERTY(Category = CameraActor, EditAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	bool bLightweightCameraRig;
+
 public:
 
+	virtual void PostInitializeComponents() override;
+
+	/* Switch between the lightweight camera rig and the camera boom. */
+	void SetLightweightCameraRig(bool bLightweight);
+
+	FORCEINLINE bool IsLightweightCameraRig() const { return bLightweightCameraRig; }
+
+	/* Returns the camera boom, idle with the lightweight camera rig. */
+	FORCEINLINE USpringArmComponent* GetCameraBoomComponent() { return CameraBoomComp; }
+
 	void MoveForward(float Val) override;
 
 	/** Handles the mouse scrolling down. */
@@ -0,0 +1,62 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+/** stats for the top down camera module, use 'stat TDC' to display them */
+DECLARE_STATS_GROUP(TEXT("TDC"), STATGROUP_TDC, STATCAT_Advanced);
+
+/** swipe/drag panning */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pan Physics Traces"), STAT_TDC_PanPhysicsTraces, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pan Plane Intersections"), STAT_TDC_PanPlaneIntersections, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pan Physics Traces/s"), STAT_TDC_PanPhysicsTracesPerSecond, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pan Plane Intersections/s"), STAT_TDC_PanPlaneIntersectionsPerSecond, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** frame time of the module */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PlayerTick"), STAT_TDC_PlayerTick, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ProcessPlayerInput"), STAT_TDC_ProcessPlayerInput, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateDetection"), STAT_TDC_UpdateDetection, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Swipe Ground Query"), STAT_TDC_SwipeGroundQuery, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MoveToMouseCursor"), STAT_TDC_MoveToMouseCursor, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spectator Movement Tick"), STAT_TDC_SpectatorMovementTick, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Significance"), STAT_TDC_Significance, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** work issued per frame */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Physics Traces"), STAT_TDC_PhysicsTraces, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Heightfield Queries"), STAT_TDC_HeightfieldQueries, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pick Cache Hits"), STAT_TDC_PickCacheHits, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Path Requests"), STAT_TDC_PathRequests, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Coalesced Move Requests"), STAT_TDC_CoalescedMoveRequests, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("SetActorLocation Calls"), STAT_TDC_SetActorLocationCalls, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** character pool, totals since the world started */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Character Pool Hits"), STAT_TDC_CharacterPoolHits, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Character Pool Misses"), STAT_TDC_CharacterPoolMisses, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Characters"), STAT_TDC_CharacterPoolFree, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** actors per significance bucket, as of the last significance update */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("High Significance Actors"), STAT_TDC_HighSignificanceActors, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Medium Significance Actors"), STAT_TDC_MediumSignificanceActors, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Low Significance Actors"), STAT_TDC_LowSignificanceActors, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Dormant Actors"), STAT_TDC_DormantActors, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sleeping Actors"), STAT_TDC_SleepingActors, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** streaming prefetch, totals since the player started */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Prefetched Levels"), STAT_TDC_PrefetchedLevels, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Prefetch Hits"), STAT_TDC_PrefetchHits, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Wasted Prefetch Loads"), STAT_TDC_WastedPrefetchLoads, STATGROUP_TDC, UE4TOPDOWNCAMERA_API);
+
+/** the same timers and counters in the CSV profile, use 'csvprofile start' to capture them */
+CSV_DECLARE_CATEGORY_EXTERN(TDC);
+
+/** time the enclosing scope, Name is the stat without its STAT_TDC_ prefix */
+#define TDC_SCOPE_CYCLE_COUNTER(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_TDC_##Name); \
+	CSV_SCOPED_TIMING_STAT(TDC, Name)
+
+/** count one event on a per frame counter, Name is the stat without its STAT_TDC_ prefix */
+#define TDC_INC_COUNTER(Name) \
+	INC_DWORD_STAT(STAT_TDC_##Name); \
+	CSV_CUSTOM_STAT(TDC, Name, 1, ECsvCustomStatOp::Accumulate)
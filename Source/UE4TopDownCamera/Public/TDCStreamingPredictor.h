@@ -0,0 +1,107 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCStreamingPredictor.generated.h"
+
+/** streaming level loaded while the predictor was watching */
+struct FTDCTrackedLevel
+{
+	/** ground bounds of the loaded level */
+	FBox2D Bounds;
+
+	/** loaded for the predicted view, not the current one */
+	bool bPrefetched;
+
+	/** was in view since it was loaded */
+	bool bSeen;
+};
+
+/**
+ * Streams in where the camera is going.
+ * The velocity of the camera is smoothed over the last frames and the view is extrapolated LookAheadTime ahead; the
+ * predicted view location is added to the locations level streaming and texture streaming load around, and a
+ * navigation invoker is kept in the predicted area for navmeshes generated around invokers.
+ * Levels loaded for the predicted view are counted as hits once they come into view and as wasted if they are
+ * unloaded before that.
+ */
+UCLASS()
+class UE4TOPDOWNCAMERA_API UTDCStreamingPredictor : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+
+	/*
+	 * Predict the view from the current one, called once per frame by the owning controller.
+	 *
+	 * @param	DeltaTime		Frame time.
+	 * @param	ViewLocation	Location of the camera.
+	 * @param	Footprint		Corners of the ground area seen by the camera, in order around it.
+	 */
+	void Update(float DeltaTime, const FVector& ViewLocation, const FVector2D Footprint[4]);
+
+	/** stop prefetching, called by the owning controller when it goes away */
+	void Shutdown();
+
+	/** world of the owning controller */
+	virtual UWorld* GetWorld() const override;
+
+	/** how far ahead, in seconds, the view is predicted */
+	float LookAheadTime;
+
+	/** time constant, in seconds, of the velocity smoothing */
+	float VelocitySmoothingTime;
+
+	/** camera speed under which nothing is prefetched */
+	float MinPredictSpeed;
+
+	/** levels loaded for the predicted view */
+	int32 GetNumPrefetchedLevels() const { return NumPrefetchedLevels; }
+
+	/** prefetched levels that came into view */
+	int32 GetNumPrefetchHits() const { return NumPrefetchHits; }
+
+	/** prefetched levels unloaded without coming into view */
+	int32 GetNumWastedLoads() const { return NumWastedLoads; }
+
+	/** fraction of the prefetched levels that came into view */
+	float GetPrefetchHitRate() const { return NumPrefetchedLevels > 0 ? float(NumPrefetchHits) / NumPrefetchedLevels : 0.0f; }
+
+protected:
+
+	/** smoothed ground velocity of the camera */
+	FVector2D Velocity;
+
+	/** view location of the last update */
+	FVector LastViewLocation;
+	bool bHasLastViewLocation;
+
+	/** set while the camera moves fast enough to predict */
+	bool bPredicting;
+
+	/** predicted view location and ground area */
+	FVector PredictedViewLocation;
+	FBox2D PredictedBounds;
+
+	/** keeps the navmesh generated in the predicted area */
+	TWeakObjectPtr<AActor> NavigationInvoker;
+	bool bNavigationInvokerRegistered;
+
+	/** adds the predicted view location after the view locations of the frame are gathered */
+	FDelegateHandle EndDrawHandle;
+	void OnEndDraw();
+
+	/** move the navigation invoker to the predicted area, or unregister it */
+	void UpdateNavigationInvoker(const FVector2D& PredictedCenter, float Radius);
+
+	/** count hits and wasted loads of the streaming levels */
+	void UpdateMetrics(const FBox2D& ViewBounds);
+
+	/** streaming levels loaded since the predictor started */
+	TMap<TWeakObjectPtr<ULevelStreaming>, FTDCTrackedLevel> TrackedLevels;
+
+	int32 NumPrefetchedLevels;
+	int32 NumPrefetchHits;
+	int32 NumWastedLoads;
+};
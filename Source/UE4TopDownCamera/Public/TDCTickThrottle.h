@@ -0,0 +1,90 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+#include "TDCWorldRegistry.h"
+
+namespace ETDCTickBand
+{
+	enum Type
+	{
+		/** in view, close to the focal point, ticks every frame */
+		NearInView,
+		/** in view, far from the focal point */
+		FarInView,
+		/** out of view, close to the focal point */
+		NearOutOfView,
+		/** out of view, far from the focal point */
+		FarOutOfView,
+		Num
+	};
+}
+
+/**
+ * Tick rates of the actors of a world, driven by the top down camera.
+ * Locations fall into bands by their distance from the camera focal point and whether they are inside the ground
+ * footprint of the view; movement, path following and animation of an actor tick at the rate of its band, and
+ * animation stops ticking the pose of actors out of view. Tick settings are only touched when an actor changes band.
+ * FTDCSignificanceManager decides the band of each actor.
+ */
+class UE4TOPDOWNCAMERA_API FTDCTickThrottle
+{
+public:
+
+	explicit FTDCTickThrottle(UWorld* InWorld);
+
+	/** throttle of the world */
+	static FTDCTickThrottle& Get(UWorld* World) { return TTDCWorldRegistry<FTDCTickThrottle>::Get(World); }
+
+	/*
+	 * Register an actor, it ticks at full rate until it is given a band.
+	 *
+	 * @returns	handle of the actor
+	 */
+	int32 Add(AActor* Actor);
+
+	/** unregister an actor */
+	void Remove(int32 Handle);
+
+	/*
+	 * Set the view the bands are measured from.
+	 *
+	 * @param	FocalPoint		Point the camera looks at.
+	 * @param	Footprint		Corners of the ground area seen by the camera, in order around it.
+	 */
+	void SetView(const FVector& FocalPoint, const FVector2D Footprint[4]);
+
+	/** band of a location in the view */
+	ETDCTickBand::Type GetBandAt(const FVector& Location) const;
+
+	/** move a registered actor to a band */
+	void SetBand(int32 Handle, ETDCTickBand::Type Band);
+
+	/** number of registered actors */
+	int32 Num() const { return Entries.Num(); }
+
+	/** distance from the focal point splitting the near and far bands, in and out of view */
+	float NearDistance;
+	float FarDistance;
+
+private:
+
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+
+		/** band the tick settings are set for, Num if none */
+		ETDCTickBand::Type Band;
+	};
+
+	/** set the tick settings of a band on an actor */
+	static void ApplyBand(AActor* Actor, ETDCTickBand::Type Band);
+
+	TSparseArray<FEntry> Entries;
+
+	/** view of the last SetView */
+	FVector2D ViewFocalPoint;
+	FVector2D ViewFootprint[4];
+	float ViewWinding;
+};
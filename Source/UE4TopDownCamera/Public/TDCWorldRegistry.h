@@ -0,0 +1,61 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "UE4TopDownCamera.h"
+
+/**
+ * One instance of T per world, created on first use and destroyed when the world is cleaned up.
+ * T is constructed with the world it belongs to.
+ */
+template<typename T>
+class TTDCWorldRegistry
+{
+public:
+
+	/** get the instance of the world, creating it if needed */
+	static T& Get(UWorld* World)
+	{
+		TTDCWorldRegistry& Registry = GetRegistry();
+		TUniquePtr<T>* Instance = Registry.Instances.Find(World);
+		if (Instance == NULL)
+		{
+			Instance = &Registry.Instances.Add(World, MakeUnique<T>(World));
+		}
+		return **Instance;
+	}
+
+	/** get the instance of the world, NULL if it has not been created */
+	static T* Find(UWorld* World)
+	{
+		TUniquePtr<T>* Instance = GetRegistry().Instances.Find(World);
+		return Instance ? Instance->Get() : NULL;
+	}
+
+	~TTDCWorldRegistry()
+	{
+		FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	}
+
+private:
+
+	TTDCWorldRegistry()
+	{
+		WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddRaw(this, &TTDCWorldRegistry::OnWorldCleanup);
+	}
+
+	static TTDCWorldRegistry& GetRegistry()
+	{
+		static TTDCWorldRegistry Registry;
+		return Registry;
+	}
+
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+	{
+		Instances.Remove(World);
+	}
+
+	TMap<UWorld*, TUniquePtr<T>> Instances;
+
+	FDelegateHandle WorldCleanupHandle;
+};
@@ -6,7 +6,7 @@ public class UE4TopDownCamera : ModuleRules
 {
 	public UE4TopDownCamera(ReadOnlyTargetRules Target) : base (Target)
 	{
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "AIModule" });
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "AIModule", "NavigationSystem" });
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
@@ -1,5 +1,37 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "UE4TopDownCamera.h"
+#include "TDCStats.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, UE4TopDownCamera, "UE4TopDownCamera" );
+
+DEFINE_STAT(STAT_TDC_PanPhysicsTraces);
+DEFINE_STAT(STAT_TDC_PanPlaneIntersections);
+DEFINE_STAT(STAT_TDC_PanPhysicsTracesPerSecond);
+DEFINE_STAT(STAT_TDC_PanPlaneIntersectionsPerSecond);
+DEFINE_STAT(STAT_TDC_PlayerTick);
+DEFINE_STAT(STAT_TDC_ProcessPlayerInput);
+DEFINE_STAT(STAT_TDC_UpdateDetection);
+DEFINE_STAT(STAT_TDC_SwipeGroundQuery);
+DEFINE_STAT(STAT_TDC_MoveToMouseCursor);
+DEFINE_STAT(STAT_TDC_SpectatorMovementTick);
+DEFINE_STAT(STAT_TDC_Significance);
+DEFINE_STAT(STAT_TDC_PhysicsTraces);
+DEFINE_STAT(STAT_TDC_HeightfieldQueries);
+DEFINE_STAT(STAT_TDC_PickCacheHits);
+DEFINE_STAT(STAT_TDC_PathRequests);
+DEFINE_STAT(STAT_TDC_CoalescedMoveRequests);
+DEFINE_STAT(STAT_TDC_SetActorLocationCalls);
+DEFINE_STAT(STAT_TDC_CharacterPoolHits);
+DEFINE_STAT(STAT_TDC_CharacterPoolMisses);
+DEFINE_STAT(STAT_TDC_CharacterPoolFree);
+DEFINE_STAT(STAT_TDC_HighSignificanceActors);
+DEFINE_STAT(STAT_TDC_MediumSignificanceActors);
+DEFINE_STAT(STAT_TDC_LowSignificanceActors);
+DEFINE_STAT(STAT_TDC_DormantActors);
+DEFINE_STAT(STAT_TDC_SleepingActors);
+DEFINE_STAT(STAT_TDC_PrefetchedLevels);
+DEFINE_STAT(STAT_TDC_PrefetchHits);
+DEFINE_STAT(STAT_TDC_WastedPrefetchLoads);
+
+CSV_DEFINE_CATEGORY(TDC, true);